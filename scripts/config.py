@@ -28,6 +28,16 @@ wfile_end = '-wfile.txt'
 only_print_net_constrain = True
 eth_name = 'eth0'
 
+transport = 'block'  # block | event | uring
+link_num = 1  # parallel connections between two nodes
+
+window = 0  # bytes of a block repaired at a time, 0 for the whole block
+direct_io = False  # read and write the local files with O_DIRECT
+writeback = False  # start writing back every stored piece at once
+durability = 'none'  # none | periodic | task, when rebuilt data is flushed
+flush_ms = 1000  # flush interval of the periodic durability
+shm_lend = False  # local nodes read big pieces out of each other's memory
+
 ips = [('127.0.0.1', 10083),
        ('127.0.0.1', 10084),
        ('127.0.0.1', 10085),
@@ -77,6 +87,10 @@ config_format = '''\
 
 {if_only_print_net_constrain}
 {eth_name}
+
+{transport} {link_num}
+
+{window} {if_direct_io} {if_writeback} {durability} {flush_ms} {if_shm_lend}
 '''
 
 def write_address_file():
@@ -107,6 +121,9 @@ def write_algorithm_file():
 def write_config_file():
     with open(config_dir + config_file, 'w') as f:
         if_only_print_net_constrain = 1 if only_print_net_constrain else 0
+        if_direct_io = 1 if direct_io else 0
+        if_writeback = 1 if writeback else 0
+        if_shm_lend = 1 if shm_lend else 0
         f.write(eval(f"f'''{config_format}'''"))
     with open(config_dir + config_format_file, 'w') as f:
         f.write(config_format)
@@ -28,7 +28,6 @@ ips = config.ips[1:]
 def stop():
     #Stop threads and clear
     do_multi_cmd('ssh {} "pkill node_main"', ips, False)
-    do_multi_cmd(('ssh {} ' f'"wondershaper -c -a {config.eth_name}"'), ips, False)
 
 if __name__ == '__main__':
     #Send files
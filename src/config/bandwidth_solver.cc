@@ -1,15 +1,16 @@
 #include "config/bandwidth_solver.hh"
 
 #include <iostream>
-#include <sstream>
+#include <utility>
 
 namespace exr {
 
 //Constructor and destructor
-BandwidthSolver::BandwidthSolver(const Name &eth, const bool &if_print)
+BandwidthSolver::BandwidthSolver(const Name &eth, const bool &if_print,
+                                 Shaper shaper)
     : is_pure_load_(eth == ""), if_print_(if_print),
       bw_num_(0), node_num_(0), cur_(0),
-      eth_(eth), reset_cmd_(kResetCmd + eth) {}
+      eth_(eth), shaper_(std::move(shaper)) {}
 
 BandwidthSolver::~BandwidthSolver() { ResetBandwidth(); Close();}
 
@@ -79,15 +80,11 @@ void BandwidthSolver::SetBandwidth(const Count &id, const bool &is_full) {
     if (download < kMinSetBandwidth) download = kMinSetBandwidth;
   }
 
-  ResetBandwidth();
-  std::stringstream fmt;
-  fmt << kSetCmd << eth_ << kUploadPara << upload
-                         << kDownloadPara << download;
   if (if_print_) {
-    std::cout << cur_ << ": " << fmt.str() << std::endl;
-  } else {
-    auto _ = system(fmt.str().c_str());
-    ++_;
+    std::cout << cur_ << ": " << eth_ << " upload " << upload
+              << " download " << download << std::endl;
+  } else if (shaper_) {
+    shaper_({upload, download});
   }
 }
 
@@ -95,18 +92,13 @@ void BandwidthSolver::SetBandwidth(const Count &id, const bool &is_full) {
 void BandwidthSolver::ResetBandwidth() {
   if (is_pure_load_) return;
   if (if_print_) {
-    std::cout << reset_cmd_ << std::endl;
-  } else {
-    auto _ = system(reset_cmd_.c_str());
-    ++_;
+    std::cout << eth_ << " unlimited" << std::endl;
+  } else if (shaper_) {
+    shaper_({0, 0});
   }
 }
 
-//Static values for bandwidth setting commands
-const CmdType BandwidthSolver::kSetCmd = "wondershaper -a ";
-const CmdType BandwidthSolver::kResetCmd = "wondershaper -c -a ";
-const CmdType BandwidthSolver::kUploadPara = " -u ";
-const CmdType BandwidthSolver::kDownloadPara = " -d ";
+//Static values for bandwidth setting
 const BwType BandwidthSolver::kFullBandwidth = 1000000;
 const BwType BandwidthSolver::kMinSetBandwidth = 5000;
 
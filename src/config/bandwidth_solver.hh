@@ -2,6 +2,7 @@
 #define EXR_CONFIG_BANDWIDTHSOLVER_HH_
 
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -10,12 +11,15 @@
 namespace exr {
 
 using LoadBwType = double;
-using CmdType = std::string;
 
 class BandwidthSolver
 {
  public:
-  BandwidthSolver(const Name &eth_name, const bool &if_print);
+  //Applies a node's bandwidth setting, {0, 0} lifts the limits
+  using Shaper = std::function<void(const Bandwidth &bw)>;
+
+  BandwidthSolver(const Name &eth_name, const bool &if_print,
+                  Shaper shaper = nullptr);
   ~BandwidthSolver();
 
   void Open(const Path &path);
@@ -41,12 +45,8 @@ class BandwidthSolver
   Count cur_;
   std::unique_ptr<Bandwidth[]> bandwidths_;
   Name eth_;
-  CmdType reset_cmd_;
+  Shaper shaper_;
 
-  static const CmdType kSetCmd;
-  static const CmdType kResetCmd;
-  static const CmdType kUploadPara;
-  static const CmdType kDownloadPara;
   static const BwType kFullBandwidth;
   static const BwType kMinSetBandwidth;
 };
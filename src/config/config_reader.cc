@@ -37,7 +37,41 @@ void ConfigReader::Load(const Path &path, const Count &id) {
   Count ifp;
   config_file >> ifp >> eth_;
   if_print_ = (ifp == 1);
+
+  config_file >> transport_ >> link_num_;
+
+  //Repair window, absent or 0 for whole blocks. Two windows are in flight,
+  //  both must fit in a memory unit without a piece crossing its end
+  if (!(config_file >> window_)) window_ = 0;
+  //Direct I/O of the local files and background writeback of the stored
+  //  pieces, each absent or 0 to go without
+  Count direct = 0, writeback = 0;
+  config_file >> direct >> writeback;
+  direct_io_ = (direct == 1);
+  writeback_ = (writeback == 1);
+  //Durability of rebuilt data: none, periodic (every flush_ms) or task
+  if (!(config_file >> durability_)) durability_ = "none";
+  if (!(config_file >> flush_ms_)) flush_ms_ = 1000;
+  //Local nodes reading big pieces out of each other, absent or 0 to copy
+  //  them through the shared memory
+  Count lend = 0;
+  config_file >> lend;
+  shm_lend_ = (lend == 1);
   config_file.close();
+  if (window_ > 0 && (window_ % psize_ != 0 || mem_size_ < 2 * window_ ||
+                      mem_size_ % window_ != 0)) {
+    std::cerr << "Window " << window_ << " must be a multiple of the piece "
+              << "size, with a memory unit holding two or more of them"
+              << std::endl;
+    exit(-1);
+  }
+  if ((durability_ != "none" && durability_ != "periodic" &&
+       durability_ != "task") || flush_ms_ <= 0) {
+    std::cerr << "Durability " << durability_ << " must be none, periodic "
+              << "or task, flushing every " << flush_ms_ << " ms when "
+              << "periodic, above 0" << std::endl;
+    exit(-1);
+  }
 }
 
 DataSize ConfigReader::get_size() { return size_; }
@@ -63,4 +97,13 @@ const Path& ConfigReader::get_write_file() { return write_file_; }
 bool ConfigReader::get_if_print() { return if_print_; }
 const Name& ConfigReader::get_eth_name() { return eth_; }
 
+const Name& ConfigReader::get_transport() { return transport_; }
+Count ConfigReader::get_link_num() { return link_num_; }
+DataSize ConfigReader::get_window() { return window_; }
+bool ConfigReader::get_direct_io() { return direct_io_; }
+bool ConfigReader::get_writeback() { return writeback_; }
+const Name& ConfigReader::get_durability() { return durability_; }
+Time ConfigReader::get_flush_ms() { return flush_ms_; }
+bool ConfigReader::get_shm_lend() { return shm_lend_; }
+
 } // namespace exr
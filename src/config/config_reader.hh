@@ -37,6 +37,15 @@ class ConfigReader
   bool get_if_print();
   const Name& get_eth_name();
 
+  const Name& get_transport();
+  Count get_link_num();
+  DataSize get_window();
+  bool get_direct_io();
+  bool get_writeback();
+  const Name& get_durability();
+  Time get_flush_ms();
+  bool get_shm_lend();
+
   //ConfigReader is neither copyable nor movable
   ConfigReader(const ConfigReader&) = delete;
   ConfigReader& operator=(const ConfigReader&) = delete;
@@ -64,6 +73,15 @@ class ConfigReader
 
   bool if_print_;
   Name eth_;
+
+  Name transport_;
+  Count link_num_;
+  DataSize window_;
+  bool direct_io_;
+  bool writeback_;
+  Name durability_;
+  Time flush_ms_;
+  bool shm_lend_;
 };
 
 } // namespace exr
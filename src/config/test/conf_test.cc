@@ -25,6 +25,8 @@ int main()
             << "data read file: " << cr.get_read_file() << std::endl
             << "data write file: " << cr.get_write_file() << std::endl
             << "if print constrain: " << cr.get_if_print() << std::endl
-            << "eth name: " << cr.get_eth_name() << std::endl;
+            << "eth name: " << cr.get_eth_name() << std::endl
+            << "transport: " << cr.get_transport() << std::endl
+            << "links per node: " << cr.get_link_num() << std::endl;
   return 0;
 }
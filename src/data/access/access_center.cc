@@ -1,47 +1,133 @@
 #include "data/access/access_center.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <iostream>
+#include <poll.h>
 #include <thread>
+#include <vector>
 
 #include "data/access/connection_solver.hh"
+#include "data/access/shm_solver.hh"
 #include "data/access/socket_solver.hh"
+#include "data/access/uring_solver.hh"
+#include "util/wire.hh"
 
 namespace exr {
 
 //Constructor and destructor
-AccessCenter::AccessCenter(const Count &id, const Count &total)
-    : id_(id), total_(total), tis(new pTI[total]) {}
+AccessCenter::AccessCenter(const Count &id, const Count &total,
+                           const Count &link_num)
+    : id_(id), total_(total), link_num_(id == 0 ? 1 : link_num),
+      tis(new pTI[total * link_num_]),
+      send_mtxs_(new std::mutex[total * link_num_]),
+      next_links_(new std::atomic<Count>[total]),
+      recv_links_(new Count[total]), local_(new bool[total]), lend_(false),
+      versions_(new Count[total]), connect_time_(0) {
+  for (Count i = 0; i < total; ++i) {
+    next_links_[i] = 0;
+    recv_links_[i] = 0;
+    local_[i] = false;
+    versions_[i] = kWireVersion;
+  }
+}
 
-AccessCenter::~AccessCenter() { if (acc_) acc_.close(); }
+AccessCenter::~AccessCenter() {
+  StopEngine();
+  if (acc_) acc_.close();
+}
 
 //Connect to others
 void AccessCenter::Connect(const IPAddressList &ip_addresses) {
-  //Start listening and receive connection from those whose ids are bigger
+  FindLocal_(ip_addresses);
+  //Shared memory of a local link is named after the acceptor's port
+  auto shm_name = [&](const Count &acceptor_id, const Count &connector_id) {
+    return "/exr-" + std::to_string(ip_addresses[acceptor_id].port) + "-" +
+           std::to_string(connector_id);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+
+  //Start listening and receive connection from those whose ids are bigger,
+  //  every accepted link finishes its handshake in a thread of its own
+  Count links = 0;
+  for (Count i = id_ + 1; i < total_; ++i) links += LinkNum_(i);
   std::thread receive_thread;
-  if (id_ != total_ - 1) {
-    acc_ = sockpp::tcp_acceptor(ip_addresses[id_].port);
+  if (links > 0) {
+    acc_ = sockpp::tcp_acceptor(ip_addresses[id_].port, links);
     if (!acc_) {
       std::cerr << acc_.last_error_str() << std::endl;
       exit(-1);
     }
-    receive_thread = std::thread([&] {
-      Count client_id;
-      for (Count i = id_ + 1; i < total_; ++i) {
-        pTI ds(new SocketSolver(acc_.accept()));
-        ds->Receive(sizeof(client_id), &client_id);
-        tis[client_id] = std::move(ds);
+    receive_thread = std::thread([&, links] {
+      std::vector<std::thread> handshakes;
+      //Links already claimed by a hello, each one is accepted once
+      std::mutex claim_mtx;
+      std::vector<bool> claimed(total_ * link_num_, false);
+      for (Count n = 0; n < links; ++n) {
+        auto sock = acc_.accept();
+        if (!sock) {
+          std::cerr << acc_.last_error_str() << std::endl;
+          exit(-1);
+        }
+        auto *ds = new SocketSolver(std::move(sock));
+        handshakes.emplace_back([&, ds] {
+          pTI link(ds);
+          //Client's version, id and which of its links this is
+          BufUnit hello[kWireHelloSize];
+          link->Receive(sizeof(hello), hello);
+          auto version = DecodeCount(hello);
+          auto peer = DecodeCount(hello + kWireCountSize);
+          auto k = DecodeCount(hello + 2 * kWireCountSize);
+          EncodeCount(kWireVersion, hello);
+          link->Send(kWireCountSize, hello);
+          CheckVersion_(peer, version);
+          {
+            std::lock_guard<std::mutex> lck(claim_mtx);
+            if (peer <= id_ || k >= LinkNum_(peer) ||
+                claimed[peer * link_num_ + k]) {
+              std::cerr << "Node " << peer << " cannot connect link " << k
+                        << " to node " << id_ << std::endl;
+              exit(-1);
+            }
+            claimed[peer * link_num_ + k] = true;
+          }
+          if (local_[peer])
+            link = ShmSolver::Accept(std::move(link), shm_name(id_, peer),
+                                     lend_);
+          Link_(peer, k) = std::move(link);
+        });
       }
+      for (auto &t : handshakes) t.join();
     });
   }
 
-  //Connect to those whose ids are smaller
+  //Connect to those whose ids are smaller, all links at the same time
+  std::vector<std::thread> connectors;
   for (Count i = 0; i < id_; ++i) {
-    tis[i] = pTI(new ConnectionSolver(ip_addresses[i]));
-    tis[i]->Send(sizeof(id_), &id_);
+    for (Count k = 0; k < LinkNum_(i); ++k) {
+      connectors.emplace_back([&, i, k] {
+        BufUnit hello[kWireHelloSize];
+        EncodeCount(kWireVersion, hello);
+        EncodeCount(id_, hello + kWireCountSize);
+        EncodeCount(k, hello + 2 * kWireCountSize);
+        pTI cs(new ConnectionSolver(ip_addresses[i]));
+        cs->Send(sizeof(hello), hello);
+        cs->Receive(kWireCountSize, hello);
+        CheckVersion_(i, DecodeCount(hello));
+        if (local_[i])
+          cs = ShmSolver::Offer(std::move(cs), shm_name(i, id_), lend_);
+        Link_(i, k) = std::move(cs);
+      });
+    }
   }
 
-  //Wait for receiving
-  if (id_ != total_ - 1) receive_thread.join();
+  //Wait for both sides
+  for (auto &t : connectors) t.join();
+  if (links > 0) receive_thread.join();
+  connect_time_ = std::chrono::duration<Time, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
 }
 
 //Send and Receive
@@ -51,7 +137,7 @@ void AccessCenter::Send(const Count &tar_id,
     std::cerr << "Cannot send data to local!!!" << std::endl;
     exit(-1);
   }
-  tis[tar_id]->Send(size, buf);
+  Link_(tar_id)->Send(size, buf);
 }
 
 void AccessCenter::Receive(const Count &src_id,
@@ -60,7 +146,225 @@ void AccessCenter::Receive(const Count &src_id,
     std::cerr << "Cannot receive from local!!!" << std::endl;
     exit(-1);
   }
-  tis[src_id]->Receive(size, buf);
+  Link_(src_id)->Receive(size, buf);
+}
+
+//Send and Receive several buffers at once
+void AccessCenter::SendV(const Count &tar_id,
+                         const Count &num, const iovec *iov) {
+  if (tar_id == id_) {
+    std::cerr << "Cannot send data to local!!!" << std::endl;
+    exit(-1);
+  }
+  Link_(tar_id)->SendV(num, iov);
+}
+
+void AccessCenter::ReceiveV(const Count &src_id,
+                            const Count &num, const iovec *iov) {
+  if (src_id == id_) {
+    std::cerr << "Cannot receive from local!!!" << std::endl;
+    exit(-1);
+  }
+  Link_(src_id)->ReceiveV(num, iov);
+}
+
+//Control messages, always on the first link and in the node's version
+void AccessCenter::SendTask(const Count &tar_id, const RepairTask &rt,
+                            const DataSize &size, BufUnit *body) {
+  BufUnit head[kWireTaskSize];
+  auto version = versions_[tar_id];
+  EncodeTask(rt, head, version);
+  iovec iov[2] = {{head, static_cast<size_t>(WireTaskSize(version))},
+                  {body, static_cast<size_t>(size)}};
+  SendV(tar_id, size > 0 ? 2 : 1, iov);
+}
+
+void AccessCenter::ReceiveTask(const Count &src_id, RepairTask &rt) {
+  BufUnit head[kWireTaskSize];
+  auto version = versions_[src_id];
+  Receive(src_id, WireTaskSize(version), head);
+  rt = DecodeTask(head, version);
+}
+
+void AccessCenter::SendCount(const Count &tar_id, const Count &c) {
+  BufUnit buf[kWireCountSize];
+  EncodeCount(c, buf);
+  Send(tar_id, sizeof(buf), buf);
+}
+
+Count AccessCenter::ReceiveCount(const Count &src_id) {
+  BufUnit buf[kWireCountSize];
+  Receive(src_id, sizeof(buf), buf);
+  return DecodeCount(buf);
+}
+
+//Send a framed piece on the next link of the target, round robin
+void AccessCenter::SendPiece(const Count &tar_id, const PieceHeader &ph,
+                             BufUnit *buf, EventEngine::Sent sent) {
+  if (tar_id == id_) {
+    std::cerr << "Cannot send data to local!!!" << std::endl;
+    exit(-1);
+  }
+  up_.Consume(ph.size);
+  Count link = tar_id * link_num_ + next_links_[tar_id]++ % LinkNum_(tar_id);
+  if (engine_ && engine_->Has(link)) {
+    engine_->Post(link, ph, buf, std::move(sent));
+    return;
+  }
+  BufUnit head[kWireHeaderSize];
+  EncodeHeader(ph, head);
+  iovec iov[2] = {{head, sizeof(head)}, {buf, static_cast<size_t>(ph.size)}};
+  std::unique_lock<std::mutex> lck(send_mtxs_[link]);
+  tis[link]->SendV(2, iov);
+  lck.unlock();
+  if (sent) sent();
+}
+
+void AccessCenter::SendFilePiece(const Count &tar_id, const PieceHeader &ph,
+                                 const int &fd, const DataSize &offset) {
+  up_.Consume(ph.size);
+  Count link = tar_id * link_num_ + next_links_[tar_id]++ % LinkNum_(tar_id);
+  if (engine_ && engine_->Has(link)) {
+    engine_->PostFile(link, ph, fd, offset);
+    return;
+  }
+  BufUnit head[kWireHeaderSize];
+  EncodeHeader(ph, head);
+  std::unique_lock<std::mutex> lck(send_mtxs_[link]);
+  tis[link]->SendFile(sizeof(head), head, fd, offset, ph.size);
+}
+
+//Every link to the node must take file ranges: a plain socket, or one the
+//  engine drives. Shared memory and io_uring links can't
+bool AccessCenter::can_send_file(const Count &peer_id) {
+  if (peer_id == 0 || peer_id == id_) return false;
+  for (Count k = 0; k < LinkNum_(peer_id); ++k) {
+    auto link = peer_id * link_num_ + k;
+    if (!(engine_ && engine_->Has(link)) && !tis[link]->can_send_file())
+      return false;
+  }
+  return true;
+}
+
+//A piece is written whole on one link, so the first readable link has one.
+//  Order among links doesn't matter: the header's offset places the piece
+BufUnit* AccessCenter::ReceivePiece(const Count &src_id, PieceHeader &ph,
+                                    const PiecePlacer &getter) {
+  if (src_id == id_) {
+    std::cerr << "Cannot receive from local!!!" << std::endl;
+    exit(-1);
+  }
+  auto n = LinkNum_(src_id);
+  Count k = 0;
+  if (n > 1) {
+    //Start from the link after the last used one so no link starves
+    std::vector<pollfd> fds(n);
+    for (Count i = 0; i < n; ++i)
+      fds[i] = {Link_(src_id, i)->handle(), POLLIN, 0};
+    while (poll(fds.data(), n, -1) < 0) {
+      if (errno != EINTR) {
+        std::cerr << "Poll links of node " << src_id << " error"
+                  << std::endl;
+        exit(-1);
+      }
+    }
+    k = recv_links_[src_id];
+    while (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) k = (k + 1) % n;
+    recv_links_[src_id] = (k + 1) % n;
+  }
+
+  auto &link = Link_(src_id, k);
+  BufUnit head[kWireHeaderSize];
+  link->Receive(sizeof(head), head);
+  ph = DecodeHeader(head);
+  auto *buf = getter(ph);
+  link->Receive(ph.size, buf);
+  down_.Consume(ph.size);
+  return buf;
+}
+
+//Let one reactor thread drive all the node-to-node sockets
+void AccessCenter::StartEngine(EventEngine::BufferGetter getter,
+                               EventEngine::PieceHandler handler) {
+  engine_ = std::make_unique<EventEngine>(total_, link_num_);
+  for (Count i = 1; i < total_; ++i) {
+    if (i == id_ || local_[i]) continue;
+    for (Count k = 0; k < link_num_; ++k)
+      if (Link_(i, k)) engine_->Add(i * link_num_ + k, Link_(i, k)->handle());
+  }
+  engine_->Run(std::move(getter), std::move(handler),
+               [&](const Count &, const DataSize &size) {
+                 return down_.Take(size);
+               });
+}
+
+void AccessCenter::StopEngine() {
+  if (engine_) engine_->Close();
+}
+
+void AccessCenter::ReleasePiece(const Count &src_id) {
+  if (is_event_driven(src_id)) engine_->Release(src_id);
+}
+
+Time AccessCenter::connect_time() { return connect_time_; }
+
+void AccessCenter::LendLocal() { lend_ = true; }
+
+Count AccessCenter::wire_version(const Count &peer_id) {
+  return versions_[peer_id];
+}
+
+//Shaping of this node as a whole
+void AccessCenter::SetBandwidth(const Bandwidth &bw) {
+  up_.SetRate(bw.upload);
+  down_.SetRate(bw.download);
+}
+
+//Whether the pieces of a node are delivered by the engine
+bool AccessCenter::is_event_driven(const Count &peer_id) {
+  return engine_ && engine_->Has(peer_id * link_num_);
+}
+
+//Wrap the established node-to-node links, the master's link stays as it is
+void AccessCenter::UseRing(IORing &owner, const iovec *rows) {
+  for (Count i = link_num_; i < total_ * link_num_; ++i) {
+    if (i / link_num_ == id_ || local_[i / link_num_] || !tis[i]) continue;
+    auto us = std::make_unique<UringSolver>(std::move(tis[i]));
+    us->ShareBuffers(owner, rows[i / link_num_]);
+    tis[i] = std::move(us);
+  }
+}
+
+//Talk in the older version of the two, refuse a peer too old for this one
+void AccessCenter::CheckVersion_(const Count &peer_id, const Count &version) {
+  if (version < kMinWireVersion || peer_id >= total_) {
+    std::cerr << "Node " << peer_id << " speaks wire version " << version
+              << ", at least " << kMinWireVersion << " is needed" << std::endl;
+    exit(-1);
+  }
+  versions_[peer_id] = std::min(version, kWireVersion);
+}
+
+//Other nodes on this host, all loopback addresses count as the same host
+void AccessCenter::FindLocal_(const IPAddressList &ip_addresses) {
+  auto loopback = [](const IP &host) {
+    return host == "localhost" || host.compare(0, 4, "127.") == 0;
+  };
+  auto &self = ip_addresses[id_].host;
+  for (Count i = 1; id_ != 0 && i < total_; ++i) {
+    auto &host = ip_addresses[i].host;
+    local_[i] = i != id_ &&
+                (host == self || (loopback(host) && loopback(self)));
+  }
+}
+
+//The master and the nodes on this host are reached by a single link
+Count AccessCenter::LinkNum_(const Count &peer_id) {
+  return peer_id == 0 || local_[peer_id] ? 1 : link_num_;
+}
+
+AccessCenter::pTI& AccessCenter::Link_(const Count &peer_id, const Count &k) {
+  return tis[peer_id * link_num_ + k];
 }
 
 } // namespace exr
@@ -1,28 +1,93 @@
 #ifndef EXR_DATA_ACCESS_ACCESSCENTER_HH_
 #define EXR_DATA_ACCESS_ACCESSCENTER_HH_
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 
 #include "sockpp/tcp_acceptor.h"
 
+#include "data/access/event_engine.hh"
 #include "data/access/transmit_interface.hh"
+#include "util/io_ring.hh"
+#include "util/token_bucket.hh"
 #include "util/typedef.hh"
+#include "util/types.hh"
 
 namespace exr {
 
+//Ways of moving pieces between nodes, chosen in the config file
+const Name kBlockTransport = "block"; //One blocking receiver per link
+const Name kEventTransport = "event"; //One epoll reactor for all links
+const Name kUringTransport = "uring"; //Blocking links driven by io_uring
+
 /* A controller that can send and receive data with other controllers */
 class AccessCenter
 {
  public:
-  AccessCenter(const Count &id, const Count &total);
+  //link_num: parallel connections between two nodes (the master has one)
+  AccessCenter(const Count &id, const Count &total,
+               const Count &link_num = 1);
   ~AccessCenter();
 
-  //Connect to others
+  //Connect to others, nodes on the same host share memory instead of TCP.
+  //  All links are set up concurrently, every link starts with a hello
+  //  that settles the wire version used with that node
   void Connect(const IPAddressList &ip_addresses);
+  //Wire version agreed with a node
+  Count wire_version(const Count &peer_id);
+  //Milliseconds the last Connect took to form the mesh
+  Time connect_time();
+  //Before Connect: let nodes on the same host read big pieces straight out
+  //  of this process, if the host's ptrace policy allows it
+  void LendLocal();
 
   //Send and Receive
   void Send(const Count &tar_id, const DataSize &size, void *buf);
   void Receive(const Count &src_id, const DataSize &size, void *buf);
+  void SendV(const Count &tar_id, const Count &num, const iovec *iov);
+  void ReceiveV(const Count &src_id, const Count &num, const iovec *iov);
+
+  //Control messages in the wire format of the version agreed with the
+  //  node. A task may carry a body of the given size behind it, like a plan
+  void SendTask(const Count &tar_id, const RepairTask &rt,
+                const DataSize &size = 0, BufUnit *body = nullptr);
+  void ReceiveTask(const Count &src_id, RepairTask &rt);
+  void SendCount(const Count &tar_id, const Count &c);
+  Count ReceiveCount(const Count &src_id);
+
+  //Send a data piece with its header, through the engine if it is running.
+  //  Pieces to a node are striped over its links and shaped on the way.
+  //  sent is called once buf may be reused, later if the engine queued it
+  void SendPiece(const Count &tar_id, const PieceHeader &ph, BufUnit *buf,
+                 EventEngine::Sent sent = nullptr);
+  //The same with the payload sent from file fd at offset by sendfile, only
+  //  if can_send_file(tar_id). The file must stay open until it is sent
+  void SendFilePiece(const Count &tar_id, const PieceHeader &ph,
+                     const int &fd, const DataSize &offset);
+  bool can_send_file(const Count &peer_id);
+  //Receive the next piece from whichever link of a node has one,
+  //  the payload is placed where getter points
+  using PiecePlacer = std::function<BufUnit*(const PieceHeader &ph)>;
+  BufUnit* ReceivePiece(const Count &src_id, PieceHeader &ph,
+                        const PiecePlacer &getter);
+
+  //Hand the links to other nodes (not the master) over to an event engine
+  void StartEngine(EventEngine::BufferGetter getter,
+                   EventEngine::PieceHandler handler);
+  void StopEngine();
+  //A piece the engine delivered from a node is consumed, credit it back
+  void ReleasePiece(const Count &src_id);
+  bool is_event_driven(const Count &peer_id);
+
+  //Shape the pieces of this node (Kbps, 0 for unlimited). Changes apply
+  //  to the next piece
+  void SetBandwidth(const Bandwidth &bw);
+
+  //Move the links to other nodes onto io_uring with the buffers pinned by
+  //  owner, rows[i] is where the pieces of node i are received
+  void UseRing(IORing &owner, const iovec *rows);
 
   //AccessCenter is neither copyable nor movable
   AccessCenter(const AccessCenter&) = delete;
@@ -31,12 +96,31 @@ class AccessCenter
  private:
   Count id_; //this ConnectionCenter's id
   Count total_; //total number of candidates
+  Count link_num_; //connections to each node except the master
   sockpp::tcp_acceptor acc_; //socket acceptor
 
-  //Sockets and Connections
+  //Sockets and Connections, link k of node i is at i * link_num_ + k
   using pTI = std::unique_ptr<TransmitInterface>;
   using TIList = std::unique_ptr<pTI[]>;
   TIList tis;
+  std::unique_ptr<std::mutex[]> send_mtxs_; //Keep pieces from interleaving
+  std::unique_ptr<std::atomic<Count>[]> next_links_; //Striping cursors
+  std::unique_ptr<Count[]> recv_links_; //Where a receiver polls first
+  std::unique_ptr<bool[]> local_; //Nodes on this host, linked by ShmSolver
+  bool lend_; //Whether ShmSolver lends pieces by address
+  std::unique_ptr<Count[]> versions_; //Wire version used with each node
+  Time connect_time_;
+
+  //Upload and download shapers of this node
+  TokenBucket up_;
+  TokenBucket down_;
+
+  void CheckVersion_(const Count &peer_id, const Count &version);
+  void FindLocal_(const IPAddressList &ip_addresses);
+  Count LinkNum_(const Count &peer_id);
+  pTI& Link_(const Count &peer_id, const Count &k = 0);
+
+  std::unique_ptr<EventEngine> engine_;
 };
 
 } // namespace exr
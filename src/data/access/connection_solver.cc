@@ -1,13 +1,32 @@
 #include "data/access/connection_solver.hh"
 
+#include <chrono>
+#include <iostream>
 #include <thread>
 
+#include "data/access/vector_io.hh"
+
 namespace exr {
 
+//Retrying a peer which isn't listening yet: the first wait, the longest
+//  wait and the number of tries (about 15 seconds in all)
+const std::chrono::milliseconds kFirstBackoff(1);
+const std::chrono::milliseconds kMaxBackoff(256);
+const Count kConnectTries = 64;
+
 ConnectionSolver::ConnectionSolver(const IPAddress &ip_ad) {
-  //Connect to the server
-  while (!conn_.connect(sockpp::inet_address(ip_ad.host, ip_ad.port)))
-    std::this_thread::yield();
+  //Connect to the server, waiting twice as long after every failure
+  auto backoff = kFirstBackoff;
+  for (Count i = 1; !conn_.connect(sockpp::inet_address(ip_ad.host,
+                                                        ip_ad.port)); ++i) {
+    if (i == kConnectTries) {
+      std::cerr << "Connect to " << ip_ad.host << ":" << ip_ad.port
+                << " error: " << conn_.last_error_str() << std::endl;
+      exit(-1);
+    }
+    std::this_thread::sleep_for(backoff);
+    backoff = std::min(backoff * 2, kMaxBackoff);
+  }
 }
 
 ConnectionSolver::~ConnectionSolver() { conn_.close(); }
@@ -22,4 +41,35 @@ void ConnectionSolver::Receive(const DataSize &size, void *buf) {
   conn_.read_n(buf, size);
 }
 
+//Send several buffers with one gathered write
+void ConnectionSolver::SendV(const Count &num, const iovec *iov) {
+  if (!WriteVN(conn_.handle(), num, iov)) {
+    std::cerr << "Send vectored message error" << std::endl;
+    exit(-1);
+  }
+}
+
+//Receive into several buffers with one scattered read
+void ConnectionSolver::ReceiveV(const Count &num, const iovec *iov) {
+  if (!ReadVN(conn_.handle(), num, iov)) {
+    std::cerr << "Receive vectored message error" << std::endl;
+    exit(-1);
+  }
+}
+
+//Get the socket descriptor
+int ConnectionSolver::handle() { return conn_.handle(); }
+
+//A plain TCP socket takes file ranges by sendfile
+bool ConnectionSolver::can_send_file() { return true; }
+
+void ConnectionSolver::SendFile(const DataSize &head_size, void *head,
+                                const int &fd, const DataSize &offset,
+                                const DataSize &size) {
+  if (!SendFileN(conn_.handle(), head_size, head, fd, offset, size)) {
+    std::cerr << "Send file range error" << std::endl;
+    exit(-1);
+  }
+}
+
 } // namespace exr
@@ -18,6 +18,13 @@ class ConnectionSolver : public TransmitInterface
   //Implement TransmitInterface: to receive/send messages
   void Send(const exr::DataSize &size, void *buf) override;
   void Receive(const exr::DataSize &size, void *buf) override;
+  void SendV(const exr::Count &num, const iovec *iov) override;
+  void ReceiveV(const exr::Count &num, const iovec *iov) override;
+  int handle() override;
+  bool can_send_file() override;
+  void SendFile(const exr::DataSize &head_size, void *head, const int &fd,
+                const exr::DataSize &offset,
+                const exr::DataSize &size) override;
 
   //ConnectionSolver is neither copyable nor movable
   ConnectionSolver(const ConnectionSolver&) = delete;
@@ -0,0 +1,374 @@
+#include "data/access/event_engine.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace exr {
+
+const DataSize kHeadSize = kWireHeaderSize;
+//Pieces taken from one connection before looking at the others
+const Count kMaxPiecesPerEvent = 16;
+const int kMaxEvents = 64;
+
+//Constructor and destructor
+EventEngine::EventEngine(const Count &total, const Count &link_num,
+                         const Count &window)
+    : total_(total), link_num_(link_num), conn_num_(total * link_num),
+      window_(window), credits_(new DataSize[total]),
+      credit_mtxs_(new std::mutex[total]),
+      credit_cvs_(new std::condition_variable[total]),
+      owed_(new std::atomic<DataSize>[total]),
+      epfd_(epoll_create1(0)), evfd_(eventfd(0, 0)),
+      conns_(new Connection[conn_num_]), paused_num_(0),
+      on_run_(false) {
+  if (epfd_ < 0 || evfd_ < 0) {
+    std::cerr << "Create event engine error" << std::endl;
+    exit(-1);
+  }
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.u32 = conn_num_;
+  epoll_ctl(epfd_, EPOLL_CTL_ADD, evfd_, &ev);
+  for (Count i = 0; i < total_; ++i) {
+    credits_[i] = window_;
+    owed_[i] = 0;
+  }
+}
+
+EventEngine::~EventEngine() {
+  Close();
+  close(evfd_);
+  close(epfd_);
+}
+
+//Register a link's socket, it will be non-blocking from now on
+void EventEngine::Add(const Count &link_id, const int &fd) {
+  auto flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  conns_[link_id].fd = fd;
+
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.u32 = link_id;
+  if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    std::cerr << "Register peer " << link_id / link_num_ << " error"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+bool EventEngine::Has(const Count &link_id) {
+  return link_id < conn_num_ && conns_[link_id].fd >= 0;
+}
+
+//Start the reactor
+void EventEngine::Run(BufferGetter getter, PieceHandler handler,
+                      Throttle throttle) {
+  getter_ = std::move(getter);
+  handler_ = std::move(handler);
+  throttle_ = std::move(throttle);
+  on_run_ = true;
+  reactor_ = std::thread([&] { Loop_(); });
+}
+
+//Wake the reactor and the waiting posters up, and wait for it to quit
+void EventEngine::Close() {
+  if (on_run_) {
+    on_run_ = false;
+    uint64_t one = 1;
+    auto _ = write(evfd_, &one, sizeof(one));
+    ++_;
+    reactor_.join();
+    for (Count i = 0; i < total_; ++i) Grant_(i, 0);
+  }
+}
+
+//Queue a piece and try to write it out at once
+void EventEngine::Post(const Count &link_id, const PieceHeader &ph,
+                       BufUnit *buf, Sent sent) {
+  SendItem item{ph, buf, 0};
+  EncodeHeader(ph, item.head);
+  item.done = std::move(sent);
+  Send_(link_id, item);
+}
+
+void EventEngine::PostFile(const Count &link_id, const PieceHeader &ph,
+                           const int &fd, const DataSize &offset) {
+  SendItem item{ph, nullptr, 0};
+  EncodeHeader(ph, item.head);
+  item.file_fd = fd;
+  item.file_off = offset;
+  Send_(link_id, item);
+}
+
+//Grant the credits back once a quarter of the window has been released,
+//  through any link of the peer still there
+void EventEngine::Release(const Count &src_id) {
+  if (++owed_[src_id] < (window_ + 3) / 4) return;
+  auto grant = owed_[src_id].exchange(0);
+  if (grant <= 0) return;
+  SendItem item{{0, 0, -grant}, nullptr, 0};
+  EncodeHeader(item.ph, item.head);
+  for (Count k = 0; k < link_num_; ++k)
+    if (Enqueue_(src_id * link_num_ + k, item, true)) return;
+}
+
+//A piece that can't be sent would leave its receiver waiting forever
+void EventEngine::Send_(const Count &link_id, const SendItem &item) {
+  if (!TakeCredit_(link_id) || !Enqueue_(link_id, item, false)) {
+    std::cerr << "Send a piece to node " << link_id / link_num_
+              << " error, its link is gone" << std::endl;
+    exit(-1);
+  }
+}
+
+//Queue an item, an urgent one goes before the pieces still waiting.
+//  False if the link is gone
+bool EventEngine::Enqueue_(const Count &link_id, const SendItem &item,
+                           const bool &urgent) {
+  auto &conn = conns_[link_id];
+  std::unique_lock<std::mutex> lck(conn.mtx);
+  if (conn.fd < 0) return false;
+  if (!urgent) {
+    conn.sends.push_back(item);
+  } else {
+    auto it = conn.sends.begin();
+    if (it != conn.sends.end() && it->sent > 0) ++it;
+    conn.sends.insert(it, item);
+  }
+  if (conn.want_out) return true;
+
+  //Nothing was pending, the socket may take it right now
+  if (!Flush_(conn)) {
+    conn.want_out = true;
+    Watch_(conn, link_id);
+  }
+  return true;
+}
+
+//Dispatch the events
+void EventEngine::Loop_() {
+  epoll_event events[kMaxEvents];
+  while (on_run_) {
+    auto n = epoll_wait(epfd_, events, kMaxEvents, Resume_());
+    if (n < 0 && errno != EINTR) {
+      std::cerr << "Event engine wait error" << std::endl;
+      exit(-1);
+    }
+    for (int i = 0; i < n; ++i) {
+      Count link_id = events[i].data.u32;
+      if (link_id == conn_num_) continue; //Closing
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        Drop_(link_id);
+        continue;
+      }
+      if (events[i].events & EPOLLIN) OnReadable_(link_id);
+      if (events[i].events & EPOLLOUT) OnWritable_(link_id);
+    }
+  }
+}
+
+//Watch the throttled connections whose time is up again, and tell how many
+//  milliseconds epoll_wait may block until the next one is due. Waking up
+//  late is made up for by the bucket's burst
+int EventEngine::Resume_() {
+  if (paused_num_ == 0) return -1;
+  auto now = Clock::now();
+  auto next = Clock::time_point::max();
+  for (Count i = 0; i < conn_num_; ++i) {
+    auto &conn = conns_[i];
+    if (!conn.paused) continue;
+    if (conn.resume > now) {
+      next = std::min(next, conn.resume);
+      continue;
+    }
+    std::unique_lock<std::mutex> lck(conn.mtx);
+    conn.paused = false;
+    --paused_num_;
+    if (conn.fd >= 0) Watch_(conn, i);
+  }
+  if (paused_num_ == 0) return -1;
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+      next - now).count();
+  return static_cast<int>((us + 999) / 1000);
+}
+
+//Stop reading a connection for a while, its writes go on
+void EventEngine::Pause_(const Count &link_id, const TTime &us) {
+  if (us <= 0) return;
+  auto &conn = conns_[link_id];
+  std::unique_lock<std::mutex> lck(conn.mtx);
+  if (conn.fd < 0) return;
+  conn.paused = true;
+  conn.resume = Clock::now() + std::chrono::microseconds(us);
+  ++paused_num_;
+  Watch_(conn, link_id);
+}
+
+//Events wanted from a connection (lock held)
+void EventEngine::Watch_(Connection &conn, const Count &link_id) {
+  epoll_event ev{};
+  ev.events = (conn.paused ? 0 : EPOLLIN) | (conn.want_out ? EPOLLOUT : 0);
+  ev.data.u32 = link_id;
+  epoll_ctl(epfd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+//Receiving state machine: header -> payload -> handler
+void EventEngine::OnReadable_(const Count &link_id) {
+  auto &conn = conns_[link_id];
+  Count peer_id = link_id / link_num_;
+  Count pieces = 0;
+  while (conn.fd >= 0 && pieces < kMaxPiecesPerEvent && !conn.paused) {
+    ssize_t s = 1; //Bytes read, 0 when the peer is gone
+    if (conn.head_got < kHeadSize) {
+      s = read(conn.fd, conn.head + conn.head_got, kHeadSize - conn.head_got);
+      if (s > 0) {
+        conn.head_got += s;
+        if (conn.head_got == kHeadSize) {
+          conn.ph = DecodeHeader(conn.head);
+          if (conn.ph.size >= 0) {
+            conn.buf = getter_(peer_id, conn.ph);
+            conn.body_got = 0;
+          }
+        }
+      }
+    } else if (conn.ph.size < 0) {
+      //Credits granted by the peer, the waiting posters may go on
+      Grant_(peer_id, -conn.ph.size);
+      conn.head_got = 0;
+      continue;
+    } else if (conn.body_got < conn.ph.size) {
+      s = read(conn.fd, conn.buf + conn.body_got,
+               conn.ph.size - conn.body_got);
+      if (s > 0) conn.body_got += s;
+    }
+    //An empty piece has no payload to read, it is completed right away
+
+    if (s == 0) {
+      Drop_(link_id);
+      return;
+    } else if (s < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) Drop_(link_id);
+      return;
+    }
+
+    //Piece completed
+    if (conn.head_got == kHeadSize && conn.ph.size >= 0 &&
+        conn.body_got == conn.ph.size) {
+      handler_(peer_id, conn.ph, conn.buf);
+      conn.head_got = 0;
+      conn.buf = nullptr;
+      ++pieces;
+      if (throttle_) Pause_(link_id, throttle_(peer_id, conn.ph.size));
+    }
+  }
+}
+
+//Sending state machine: drain the queue until the socket is full
+void EventEngine::OnWritable_(const Count &link_id) {
+  auto &conn = conns_[link_id];
+  std::unique_lock<std::mutex> lck(conn.mtx);
+  if (conn.fd < 0 || !Flush_(conn)) return;
+  conn.want_out = false;
+  Watch_(conn, link_id);
+}
+
+//Write queued pieces (lock held). Return false if the socket is full,
+//  true if all of them are sent
+bool EventEngine::Flush_(Connection &conn) {
+  while (!conn.sends.empty()) {
+    auto &item = conn.sends.front();
+    DataSize size = item.ph.size > 0 ? item.ph.size : 0;
+
+    iovec iov[2];
+    int num = 0;
+    if (item.sent < kHeadSize) {
+      iov[num++] = {item.head + item.sent,
+                    static_cast<size_t>(kHeadSize - item.sent)};
+    }
+    DataSize body_sent = item.sent > kHeadSize ? item.sent - kHeadSize : 0;
+    if (size > body_sent && item.buf) {
+      iov[num++] = {item.buf + body_sent,
+                    static_cast<size_t>(size - body_sent)};
+    }
+
+    ssize_t s = 0;
+    if (num > 0) {
+      s = writev(conn.fd, iov, num);
+    } else if (size > body_sent) {
+      //The header is out, the file's range follows without a copy
+      off_t off = item.file_off + body_sent;
+      s = sendfile(conn.fd, item.file_fd, &off, size - body_sent);
+      if (s == 0) { //File shorter than the piece
+        s = -1;
+        errno = EIO;
+      }
+    }
+    if (s < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+      std::cerr << "Event engine send error" << std::endl;
+      Finish_(conn);
+      return true;
+    }
+    item.sent += s;
+    if (item.sent == kHeadSize + size) {
+      if (item.done) item.done();
+      conn.sends.pop_front();
+    }
+  }
+  return true;
+}
+
+//Give back the buffers of every queued piece and forget them (lock held)
+void EventEngine::Finish_(Connection &conn) {
+  for (auto &item : conn.sends)
+    if (item.done) item.done();
+  conn.sends.clear();
+}
+
+//Every piece needs a credit, even an empty one since the receiver
+//  releases every piece it is handed. Wait for one unless the link is gone
+//  or the engine stopped, then there is none
+bool EventEngine::TakeCredit_(const Count &link_id) {
+  if (window_ == 0) return true;
+  auto peer_id = link_id / link_num_;
+  auto &conn = conns_[link_id];
+  std::unique_lock<std::mutex> lck(credit_mtxs_[peer_id]);
+  credit_cvs_[peer_id].wait(lck, [&] {
+    return credits_[peer_id] > 0 || conn.fd < 0 || !on_run_;
+  });
+  if (credits_[peer_id] <= 0) return false;
+  --credits_[peer_id];
+  return true;
+}
+
+//Give credits to the pieces of a peer, 0 just wakes its posters up
+void EventEngine::Grant_(const Count &peer_id, const DataSize &num) {
+  std::unique_lock<std::mutex> lck(credit_mtxs_[peer_id]);
+  credits_[peer_id] += num;
+  lck.unlock();
+  credit_cvs_[peer_id].notify_all();
+}
+
+//The peer is gone, stop watching it
+void EventEngine::Drop_(const Count &link_id) {
+  auto &conn = conns_[link_id];
+  std::unique_lock<std::mutex> lck(conn.mtx);
+  if (conn.fd < 0) return;
+  epoll_ctl(epfd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+  conn.fd = -1;
+  Finish_(conn);
+  lck.unlock();
+  Grant_(link_id / link_num_, 0);
+}
+
+} // namespace exr
@@ -0,0 +1,146 @@
+#ifndef EXR_DATA_ACCESS_EVENTENGINE_HH_
+#define EXR_DATA_ACCESS_EVENTENGINE_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "util/typedef.hh"
+#include "util/types.hh"
+#include "util/wire.hh"
+
+namespace exr {
+
+/* An epoll reactor which owns the node-to-node sockets and moves data
+   pieces through non-blocking send and receive state machines.
+   Link k of peer i is identified as i * link_num + k.
+   Sending is credit based: a peer is sent at most window pieces that it
+   hasn't released yet, released pieces are granted back in batches.
+   A piece is queued only with a credit, so posting waits while the peer
+   has none left */
+class EventEngine
+{
+ public:
+  //Where an incoming piece is placed, and who gets it when completed
+  using BufferGetter =
+      std::function<BufUnit*(const Count &src_id, const PieceHeader &ph)>;
+  using PieceHandler = std::function<void(const Count &src_id,
+                                          const PieceHeader &ph,
+                                          BufUnit *buf)>;
+  //Microseconds to stop reading a link for after a piece it delivered,
+  //  for download shaping. The other links go on meanwhile
+  using Throttle =
+      std::function<TTime(const Count &src_id, const DataSize &size)>;
+  //A posted piece's buffer is no longer needed: it is sent, or dropped
+  //  with its link. Called with the link locked, it must not post
+  using Sent = std::function<void()>;
+
+  EventEngine(const Count &total, const Count &link_num = 1,
+              const Count &window = 64);
+  ~EventEngine();
+
+  //Register a connected socket of a peer's link
+  void Add(const Count &link_id, const int &fd);
+  bool Has(const Count &link_id);
+
+  //Start and stop the reactor thread
+  void Run(BufferGetter getter, PieceHandler handler,
+           Throttle throttle = nullptr);
+  void Close();
+
+  //Queue a piece to a link, the buffer must live until sent is called.
+  //  Blocks while the peer has no credit left, exits if the link is gone
+  void Post(const Count &link_id, const PieceHeader &ph, BufUnit *buf,
+            Sent sent = nullptr);
+  //Queue a piece whose payload is read from a file at offset by sendfile,
+  //  the file must stay open until it is sent
+  void PostFile(const Count &link_id, const PieceHeader &ph, const int &fd,
+                const DataSize &offset);
+
+  //A piece delivered from a peer has been consumed, its credit may return
+  void Release(const Count &src_id);
+
+  //EventEngine is neither copyable nor movable
+  EventEngine(const EventEngine&) = delete;
+  EventEngine& operator=(const EventEngine&) = delete;
+
+ private:
+  struct SendItem {
+    PieceHeader ph;
+    BufUnit *buf; //nullptr if the payload comes from a file
+    DataSize sent; //Bytes of header and payload already written
+    BufUnit head[kWireHeaderSize]; //ph as it goes on the wire
+    int file_fd;
+    DataSize file_off;
+    Sent done; //Told when the buffer may be reused
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Connection {
+    std::atomic<int> fd; //-1 once dropped, read by posters waiting
+    //Receiving state: header first, then the payload
+    BufUnit head[kWireHeaderSize];
+    PieceHeader ph;
+    DataSize head_got;
+    BufUnit *buf;
+    DataSize body_got;
+    //Sending state
+    std::deque<SendItem> sends;
+    bool want_out;
+    //Throttled: not watched for reading until resume, only the reactor
+    //  sets it
+    bool paused;
+    Clock::time_point resume;
+    std::mutex mtx;
+    Connection() : fd(-1), head_got(0), buf(nullptr), body_got(0),
+                   want_out(false), paused(false) {}
+  };
+
+  Count total_;
+  Count link_num_;
+  Count conn_num_; //total_ * link_num_, also the eventfd's id
+
+  //Credits: pieces this node may still send to each peer, and pieces
+  //  released by this node but not granted back to their sender yet.
+  //  Posters wait on a peer's condition variable for its credits
+  Count window_;
+  std::unique_ptr<DataSize[]> credits_;
+  std::unique_ptr<std::mutex[]> credit_mtxs_;
+  std::unique_ptr<std::condition_variable[]> credit_cvs_;
+  std::unique_ptr<std::atomic<DataSize>[]> owed_;
+  int epfd_; //epoll instance
+  int evfd_; //eventfd used to wake up the reactor when closing
+  std::unique_ptr<Connection[]> conns_;
+
+  BufferGetter getter_;
+  PieceHandler handler_;
+  Throttle throttle_;
+  Count paused_num_; //Throttled connections, only used by the reactor
+  std::atomic<bool> on_run_; //Cleared by Close from another thread
+  std::thread reactor_;
+
+  void Loop_();
+  int Resume_();
+  void Pause_(const Count &link_id, const TTime &us);
+  void Watch_(Connection &conn, const Count &link_id);
+  void OnReadable_(const Count &link_id);
+  void OnWritable_(const Count &link_id);
+  void Send_(const Count &link_id, const SendItem &item);
+  bool Enqueue_(const Count &link_id, const SendItem &item,
+                const bool &urgent);
+  bool Flush_(Connection &conn);
+  static void Finish_(Connection &conn);
+  bool TakeCredit_(const Count &link_id);
+  void Grant_(const Count &peer_id, const DataSize &num);
+  void Drop_(const Count &link_id);
+};
+
+} // namespace exr
+
+#endif // EXR_DATA_ACCESS_EVENTENGINE_HH_
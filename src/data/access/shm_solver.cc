@@ -0,0 +1,301 @@
+#include "data/access/shm_solver.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+namespace exr {
+
+//Bytes of data in one direction, placed behind the ring's head
+const uint64_t kShmRingBytes = 1 << 22;
+const DataSize kShmHeadBytes = 256;
+//Offset of the second ring in the segment, and the segment's size
+const DataSize kShmRingStride = kShmHeadBytes + kShmRingBytes;
+const DataSize kShmSize = 2 * kShmRingStride;
+//Checks of an empty/full ring before going to sleep
+const int kShmSpins = 1024;
+//Writes from this size on are lent by address instead of copied in
+const DataSize kShmLendBytes = 1 << 16;
+//Sleep on a futex at most this long before checking the peer is alive
+const long kShmWaitNs = 100 * 1000 * 1000;
+//Read back by the peer to check that it can read this process
+const uint64_t kShmProbe = 0x6578722d73686d31;
+
+//False if it timed out
+static bool FutexWait(std::atomic<uint32_t> &word, const uint32_t &val) {
+  timespec timeout{0, kShmWaitNs};
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT,
+                 val, &timeout, nullptr, 0) == 0 || errno != ETIMEDOUT;
+}
+
+static void FutexWake(std::atomic<uint32_t> &word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE,
+          1, nullptr, nullptr, 0);
+}
+
+//Create the segment and tell the peer whether it worked
+ShmSolver::pTI ShmSolver::Offer(pTI conn, const Name &name,
+                                const bool &lend) {
+  shm_unlink(name.c_str());
+  void *mem = nullptr;
+  auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd >= 0) {
+    if (ftruncate(fd, kShmSize) == 0) mem = Map(fd);
+    close(fd);
+  }
+
+  char ok = mem != nullptr, ack = 0;
+  conn->Send(sizeof(ok), &ok);
+  if (ok) conn->Receive(sizeof(ack), &ack);
+  shm_unlink(name.c_str());
+  if (!ack) {
+    if (mem) munmap(mem, kShmSize);
+    return conn;
+  }
+  auto *shm = new ShmSolver(std::move(conn), mem, true);
+  shm->Handshake_(lend);
+  return pTI(shm);
+}
+
+//Map the segment created by the peer
+ShmSolver::pTI ShmSolver::Accept(pTI conn, const Name &name,
+                                 const bool &lend) {
+  char ok = 0;
+  conn->Receive(sizeof(ok), &ok);
+  if (!ok) return conn;
+
+  void *mem = nullptr;
+  auto fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd >= 0) {
+    mem = Map(fd);
+    close(fd);
+  }
+  char ack = mem != nullptr;
+  conn->Send(sizeof(ack), &ack);
+  if (!ack) return conn;
+  auto *shm = new ShmSolver(std::move(conn), mem, false);
+  shm->Handshake_(lend);
+  return pTI(shm);
+}
+
+//The creator writes into the first ring and reads from the second
+ShmSolver::ShmSolver(pTI conn, void *mem, const bool &creator)
+    : conn_(std::move(conn)), mem_(mem),
+      out_(RingAt(mem, creator ? 0 : 1)), in_(RingAt(mem, creator ? 1 : 0)),
+      peer_pid_(0), direct_(false), probe_(kShmProbe), lent_(0), left_(0),
+      addr_(0) {
+  static_assert(sizeof(Ring) <= kShmHeadBytes, "ring head too big");
+}
+
+ShmSolver::~ShmSolver() { munmap(mem_, kShmSize); }
+
+//Send messages to another process
+void ShmSolver::Send(const DataSize &size, void *buf) {
+  Write_(static_cast<BufUnit*>(buf), size);
+}
+
+//Receive messages from another process
+void ShmSolver::Receive(const DataSize &size, void *buf) {
+  Read_(static_cast<BufUnit*>(buf), size);
+}
+
+//The buffers are copied one after another, nothing goes in between
+void ShmSolver::SendV(const Count &num, const iovec *iov) {
+  for (Count i = 0; i < num; ++i)
+    Write_(static_cast<BufUnit*>(iov[i].iov_base), iov[i].iov_len);
+}
+
+void ShmSolver::ReceiveV(const Count &num, const iovec *iov) {
+  for (Count i = 0; i < num; ++i)
+    Read_(static_cast<BufUnit*>(iov[i].iov_base), iov[i].iov_len);
+}
+
+int ShmSolver::handle() { return conn_->handle(); }
+
+//Map a segment, zero-filled when it is created
+void* ShmSolver::Map(const int &fd) {
+  auto *mem = mmap(nullptr, kShmSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+  return mem == MAP_FAILED ? nullptr : mem;
+}
+
+ShmSolver::Ring* ShmSolver::RingAt(void *mem, const Count &i) {
+  return reinterpret_cast<Ring*>(static_cast<BufUnit*>(mem) +
+                                 i * kShmRingStride);
+}
+
+//Tell the peer where this process is and, when lending, try to read it
+//  back. Writes are lent only if both sides could read each other
+void ShmSolver::Handshake_(const bool &lend) {
+  uint64_t mine[2] = {static_cast<uint64_t>(getpid()),
+                      reinterpret_cast<uintptr_t>(&probe_)};
+  uint64_t theirs[2];
+  conn_->Send(sizeof(mine), mine);
+  conn_->Receive(sizeof(theirs), theirs);
+  peer_pid_ = theirs[0];
+
+  uint64_t probe = 0;
+  char ok = lend && Take_(reinterpret_cast<BufUnit*>(&probe), theirs[1],
+                          sizeof(probe)) && probe == kShmProbe;
+  char peer_ok = 0;
+  conn_->Send(sizeof(ok), &ok);
+  conn_->Receive(sizeof(peer_ok), &peer_ok);
+  direct_ = ok && peer_ok;
+}
+
+//Sleep until word is no longer val, the peer must still be there
+void ShmSolver::Wait_(std::atomic<uint32_t> &word, const uint32_t &val) {
+  if (FutexWait(word, val)) return;
+  if (kill(peer_pid_, 0) != 0 && errno == ESRCH) {
+    std::cerr << "Local node " << peer_pid_ << " is gone" << std::endl;
+    exit(-1);
+  }
+}
+
+//Copy size bytes at addr of the peer into buf
+bool ShmSolver::Take_(BufUnit *buf, const uint64_t &addr,
+                      const DataSize &size) {
+  for (DataSize done = 0; done < size; ) {
+    iovec local{buf + done, static_cast<size_t>(size - done)};
+    iovec remote{reinterpret_cast<void*>(addr + done),
+                 static_cast<size_t>(size - done)};
+    auto s = process_vm_readv(peer_pid_, &local, 1, &remote, 1, 0);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) return false;
+    done += s;
+  }
+  return true;
+}
+
+//A big write is lent by address, the buffer is only given back once the
+//  peer has copied it
+void ShmSolver::Write_(const BufUnit *buf, DataSize size) {
+  if (size <= 0) return;
+  Record rec{static_cast<uint64_t>(size), 0};
+  if (direct_ && size >= kShmLendBytes)
+    rec.addr = reinterpret_cast<uintptr_t>(buf);
+  WriteRing_(reinterpret_cast<BufUnit*>(&rec), sizeof(rec));
+  if (!rec.addr) {
+    WriteRing_(buf, size);
+    return;
+  }
+
+  ++lent_;
+  int spins = 0;
+  while (out_->taken.load() < lent_) {
+    if (++spins < kShmSpins) continue;
+    auto seq = out_->taken_seq.load();
+    out_->taker_wait = 1;
+    if (out_->taken.load() < lent_) Wait_(out_->taken_seq, seq);
+  }
+}
+
+//A record is read across as many calls as the caller needs
+void ShmSolver::Read_(BufUnit *buf, DataSize size) {
+  while (size > 0) {
+    if (left_ == 0) {
+      Record rec;
+      ReadRing_(reinterpret_cast<BufUnit*>(&rec), sizeof(rec));
+      left_ = rec.size;
+      addr_ = rec.addr;
+      continue;
+    }
+
+    auto len = std::min<uint64_t>(left_, static_cast<uint64_t>(size));
+    if (!addr_) {
+      ReadRing_(buf, len);
+    } else if (Take_(buf, addr_, len)) {
+      addr_ += len;
+    } else {
+      std::cerr << "Read the memory of a local node error" << std::endl;
+      exit(-1);
+    }
+    buf += len;
+    size -= len;
+    left_ -= len;
+
+    //The writer may have its buffer back
+    if (left_ == 0 && addr_) {
+      ++(in_->taken);
+      if (in_->taker_wait.exchange(0)) {
+        ++(in_->taken_seq);
+        FutexWake(in_->taken_seq);
+      }
+    }
+  }
+}
+
+//Copy in as much as the ring takes, sleep while it is full
+void ShmSolver::WriteRing_(const BufUnit *buf, DataSize size) {
+  auto *data = reinterpret_cast<BufUnit*>(out_) + kShmHeadBytes;
+  auto head = out_->head.load(std::memory_order_relaxed);
+  int spins = 0;
+  while (size > 0) {
+    auto space = kShmRingBytes - (head - out_->tail.load());
+    if (space == 0) {
+      if (++spins < kShmSpins) continue;
+      auto seq = out_->space_seq.load();
+      out_->writer_wait = 1;
+      if (kShmRingBytes == head - out_->tail.load())
+        Wait_(out_->space_seq, seq);
+      continue;
+    }
+    spins = 0;
+
+    //Up to the end of the ring, the rest goes in the next round
+    auto pos = head % kShmRingBytes;
+    auto len = std::min<uint64_t>({space, kShmRingBytes - pos,
+                                   static_cast<uint64_t>(size)});
+    memcpy(data + pos, buf, len);
+    head += len;
+    buf += len;
+    size -= len;
+    out_->head.store(head);
+    if (out_->reader_wait.exchange(0)) {
+      ++(out_->data_seq);
+      FutexWake(out_->data_seq);
+    }
+  }
+}
+
+//Copy out until the buffer is filled, sleep while the ring is empty
+void ShmSolver::ReadRing_(BufUnit *buf, DataSize size) {
+  auto *data = reinterpret_cast<BufUnit*>(in_) + kShmHeadBytes;
+  auto tail = in_->tail.load(std::memory_order_relaxed);
+  int spins = 0;
+  while (size > 0) {
+    auto avail = in_->head.load() - tail;
+    if (avail == 0) {
+      if (++spins < kShmSpins) continue;
+      auto seq = in_->data_seq.load();
+      in_->reader_wait = 1;
+      if (in_->head.load() == tail) Wait_(in_->data_seq, seq);
+      continue;
+    }
+    spins = 0;
+
+    auto pos = tail % kShmRingBytes;
+    auto len = std::min<uint64_t>({avail, kShmRingBytes - pos,
+                                   static_cast<uint64_t>(size)});
+    memcpy(buf, data + pos, len);
+    tail += len;
+    buf += len;
+    size -= len;
+    in_->tail.store(tail);
+    if (in_->writer_wait.exchange(0)) {
+      ++(in_->space_seq);
+      FutexWake(in_->space_seq);
+    }
+  }
+}
+
+} // namespace exr
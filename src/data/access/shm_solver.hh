@@ -0,0 +1,99 @@
+#ifndef EXR_DATA_ACCESS_SHMSOLVER_HH_
+#define EXR_DATA_ACCESS_SHMSOLVER_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+
+#include "data/access/transmit_interface.hh"
+#include "util/typedef.hh"
+
+namespace exr {
+
+/* Send/receive data through ring buffers in a shared memory segment,
+   for two nodes running on the same host. The TCP connection it wraps is
+   only used to set the segment up.
+   Every write is a record in the ring. If both sides lend, a big one only
+   leaves its address there: the reader copies it straight out of the
+   writer's memory with process_vm_readv, so a piece is copied once, and
+   the writer waits until it is taken. The ptrace policy of the host must
+   let the nodes read each other for that. Small ones, and all of them
+   otherwise, are copied through the ring */
+class ShmSolver : public TransmitInterface
+{
+ public:
+  using pTI = std::unique_ptr<TransmitInterface>;
+
+  //Both sides of a connection call one of them with the same name, lend
+  //  to send big writes by address. The connection is given back unchanged
+  //  if the segment can't be shared
+  static pTI Offer(pTI conn, const Name &name, const bool &lend = false);
+  static pTI Accept(pTI conn, const Name &name, const bool &lend = false);
+
+  ~ShmSolver();
+
+  //Implement TransmitInterface: to receive/send messages
+  void Send(const DataSize &size, void *buf) override;
+  void Receive(const DataSize &size, void *buf) override;
+  void SendV(const Count &num, const iovec *iov) override;
+  void ReceiveV(const Count &num, const iovec *iov) override;
+  int handle() override;
+
+  //ShmSolver is neither copyable nor movable
+  ShmSolver(const ShmSolver&) = delete;
+  ShmSolver& operator=(const ShmSolver&) = delete;
+
+ private:
+  //Head of a single producer single consumer ring, the data follows it.
+  //  The seq words are futexes to sleep on when the ring is empty/full,
+  //  or while a record left by address is not taken yet
+  struct Ring {
+    alignas(64) std::atomic<uint64_t> head; //Bytes written
+    std::atomic<uint32_t> data_seq;
+    std::atomic<uint32_t> reader_wait;
+    alignas(64) std::atomic<uint64_t> tail; //Bytes read
+    std::atomic<uint32_t> space_seq;
+    std::atomic<uint32_t> writer_wait;
+    alignas(64) std::atomic<uint64_t> taken; //Records copied by address
+    std::atomic<uint32_t> taken_seq;
+    std::atomic<uint32_t> taker_wait;
+  };
+
+  //A record: size bytes following it, or at addr of the writer if not 0
+  struct Record {
+    uint64_t size;
+    uint64_t addr;
+  };
+
+  pTI conn_;
+  void *mem_;
+  Ring *out_;
+  Ring *in_;
+
+  //Copying by address: the peer's process, whether it can read this one,
+  //  and the records sent that way
+  pid_t peer_pid_;
+  bool direct_;
+  uint64_t probe_;
+  uint64_t lent_;
+  //The record being read: bytes left, and where they are if by address
+  uint64_t left_;
+  uint64_t addr_;
+
+  ShmSolver(pTI conn, void *mem, const bool &creator);
+
+  static void* Map(const int &fd);
+  static Ring* RingAt(void *mem, const Count &i);
+  void Handshake_(const bool &lend);
+  void Wait_(std::atomic<uint32_t> &word, const uint32_t &val);
+  bool Take_(BufUnit *buf, const uint64_t &addr, const DataSize &size);
+  void Write_(const BufUnit *buf, DataSize size);
+  void Read_(BufUnit *buf, DataSize size);
+  void WriteRing_(const BufUnit *buf, DataSize size);
+  void ReadRing_(BufUnit *buf, DataSize size);
+};
+
+} // namespace exr
+
+#endif // EXR_DATA_ACCESS_SHMSOLVER_HH_
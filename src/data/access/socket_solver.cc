@@ -1,7 +1,10 @@
 #include "data/access/socket_solver.hh"
 
+#include <iostream>
 #include <utility>
 
+#include "data/access/vector_io.hh"
+
 namespace exr {
 
 SocketSolver::SocketSolver(sockpp::tcp_socket sock)
@@ -19,4 +22,35 @@ void SocketSolver::Receive(const DataSize &size, void *buf) {
   sock_.read_n(buf, size);
 }
 
+//Send several buffers with one gathered write
+void SocketSolver::SendV(const Count &num, const iovec *iov) {
+  if (!WriteVN(sock_.handle(), num, iov)) {
+    std::cerr << "Send vectored message error" << std::endl;
+    exit(-1);
+  }
+}
+
+//Receive into several buffers with one scattered read
+void SocketSolver::ReceiveV(const Count &num, const iovec *iov) {
+  if (!ReadVN(sock_.handle(), num, iov)) {
+    std::cerr << "Receive vectored message error" << std::endl;
+    exit(-1);
+  }
+}
+
+//Get the socket descriptor
+int SocketSolver::handle() { return sock_.handle(); }
+
+//A plain TCP socket takes file ranges by sendfile
+bool SocketSolver::can_send_file() { return true; }
+
+void SocketSolver::SendFile(const DataSize &head_size, void *head,
+                            const int &fd, const DataSize &offset,
+                            const DataSize &size) {
+  if (!SendFileN(sock_.handle(), head_size, head, fd, offset, size)) {
+    std::cerr << "Send file range error" << std::endl;
+    exit(-1);
+  }
+}
+
 } // namespace exr
@@ -18,6 +18,12 @@ class SocketSolver : public TransmitInterface
   //Implement TransmitInterface: to receive/send messages
   void Send(const DataSize &size, void *buf) override;
   void Receive(const DataSize &size, void *buf) override;
+  void SendV(const Count &num, const iovec *iov) override;
+  void ReceiveV(const Count &num, const iovec *iov) override;
+  int handle() override;
+  bool can_send_file() override;
+  void SendFile(const DataSize &head_size, void *head, const int &fd,
+                const DataSize &offset, const DataSize &size) override;
 
   //SocketSolver is neither copyable nor movable
   SocketSolver(const SocketSolver&) = delete;
@@ -31,7 +31,8 @@ int main()
     t[i] = std::thread([&, i] {
       ac[i].Connect(ip_ads);
       std::unique_lock<std::mutex> lck(mtx);
-      std::cout << "node " << i << " connected" << std::endl;
+      std::cout << "node " << i << " connected in "
+                << ac[i].connect_time() << " ms" << std::endl;
       lck.unlock();
     });
   }
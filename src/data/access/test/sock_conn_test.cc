@@ -56,6 +56,17 @@ int main()
             << " and n2 read: " << buf2
             << std::endl;
 
+  //Scatter/gather test
+  exr::Count head = 7, head2 = 0;
+  char buf3[100] = "";
+  iovec siov[2] = {{&head, sizeof(head)}, {buf1, 12}};
+  iovec riov[2] = {{&head2, sizeof(head2)}, {buf3, 12}};
+  n2->SendV(2, siov);
+  n1->ReceiveV(2, riov);
+  std::cout << "n2 sent: " << head << " " << buf1
+            << " and n1 read: " << head2 << " " << buf3
+            << std::endl;
+
   acc.close();
   return 0;
 }
@@ -1,6 +1,10 @@
 #ifndef EXR_DATA_ACCESS_TRANSMITINTERFACE_HH_
 #define EXR_DATA_ACCESS_TRANSMITINTERFACE_HH_
 
+#include <cstdlib>
+#include <iostream>
+#include <sys/uio.h>
+
 #include "util/typedef.hh"
 
 namespace exr {
@@ -16,6 +20,22 @@ class TransmitInterface
   //To receive data from others
   virtual void Receive(const DataSize &size, void *buf) = 0;
 
+  //Send/receive several buffers as one message (scatter/gather)
+  virtual void SendV(const Count &num, const iovec *iov) = 0;
+  virtual void ReceiveV(const Count &num, const iovec *iov) = 0;
+
+  //The descriptor under the connection, for event-driven transmission
+  virtual int handle() = 0;
+
+  //Send a header and then a range of a file, without copying the file
+  //  through user space. Only when can_send_file() says the connection can
+  virtual bool can_send_file() { return false; }
+  virtual void SendFile(const DataSize &head_size, void *head, const int &fd,
+                        const DataSize &offset, const DataSize &size) {
+    std::cerr << "This connection cannot send files" << std::endl;
+    exit(-1);
+  }
+
   //Virtual Destructor
   virtual ~TransmitInterface() {}
 };
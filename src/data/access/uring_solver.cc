@@ -0,0 +1,59 @@
+#include "data/access/uring_solver.hh"
+
+#include <iostream>
+#include <utility>
+
+namespace exr {
+
+//Ring depth of a connection, ops on a stream are issued one by one
+const Count kLinkRingDepth = 4;
+
+//Constructor and destructor
+UringSolver::UringSolver(std::unique_ptr<TransmitInterface> conn)
+    : conn_(std::move(conn)),
+      send_ring_(kLinkRingDepth), recv_ring_(kLinkRingDepth) {}
+
+UringSolver::~UringSolver() = default;
+
+void UringSolver::ShareBuffers(IORing &owner, const iovec &row) {
+  send_ring_.ShareBuffers(owner);
+  if (!recv_ring_.ShareBuffers(owner)) recv_ring_.RegisterBuffers(1, &row);
+}
+
+//Send messages to another host
+void UringSolver::Send(const DataSize &size, void *buf) {
+  iovec iov{buf, static_cast<size_t>(size)};
+  Transmit_(send_ring_, true, 1, &iov);
+}
+
+//Receive messages from another host
+void UringSolver::Receive(const DataSize &size, void *buf) {
+  iovec iov{buf, static_cast<size_t>(size)};
+  Transmit_(recv_ring_, false, 1, &iov);
+}
+
+//Header and payload go out as a single writev op
+void UringSolver::SendV(const Count &num, const iovec *iov) {
+  Transmit_(send_ring_, true, num, iov);
+}
+
+void UringSolver::ReceiveV(const Count &num, const iovec *iov) {
+  Transmit_(recv_ring_, false, num, iov);
+}
+
+int UringSolver::handle() { return conn_->handle(); }
+
+void UringSolver::Transmit_(IORing &ring, const bool &is_write,
+                            const Count &num, const iovec *iov) {
+  for (Count i = 0; i < num; i += kMaxRingVecNum) {
+    IORing::Op op{is_write, conn_->handle(), -1, 0, {}, 0};
+    for (; op.num < kMaxRingVecNum && i + op.num < num; ++op.num)
+      op.iov[op.num] = iov[i + op.num];
+    if (!ring.Submit(1, &op)) {
+      std::cerr << "io_uring transmission error" << std::endl;
+      exit(-1);
+    }
+  }
+}
+
+} // namespace exr
@@ -0,0 +1,47 @@
+#ifndef EXR_DATA_ACCESS_URINGSOLVER_HH_
+#define EXR_DATA_ACCESS_URINGSOLVER_HH_
+
+#include <memory>
+
+#include "data/access/transmit_interface.hh"
+#include "util/io_ring.hh"
+#include "util/typedef.hh"
+
+namespace exr {
+
+/* Send/receive data of an established connection through io_uring */
+class UringSolver : public TransmitInterface
+{
+ public:
+  UringSolver(std::unique_ptr<TransmitInterface> conn);
+  ~UringSolver();
+
+  //Use the buffers pinned by owner. Pieces are received into the peer's
+  //  row only, which is pinned alone if owner's buffers can't be shared
+  void ShareBuffers(IORing &owner, const iovec &row);
+
+  //Implement TransmitInterface: to receive/send messages
+  void Send(const DataSize &size, void *buf) override;
+  void Receive(const DataSize &size, void *buf) override;
+  void SendV(const Count &num, const iovec *iov) override;
+  void ReceiveV(const Count &num, const iovec *iov) override;
+  int handle() override;
+
+  //UringSolver is neither copyable nor movable
+  UringSolver(const UringSolver&) = delete;
+  UringSolver& operator=(const UringSolver&) = delete;
+
+ private:
+  //The wrapped connection, still owning the socket
+  std::unique_ptr<TransmitInterface> conn_;
+  //Separated rings so that sending never waits for receiving
+  IORing send_ring_;
+  IORing recv_ring_;
+
+  void Transmit_(IORing &ring, const bool &is_write,
+                 const Count &num, const iovec *iov);
+};
+
+} // namespace exr
+
+#endif // EXR_DATA_ACCESS_URINGSOLVER_HH_
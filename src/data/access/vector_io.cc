@@ -0,0 +1,79 @@
+#include "data/access/vector_io.hh"
+
+#include <cerrno>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace exr {
+
+//Skip the bytes already transmitted, return the first unfinished buffer
+static iovec* SkipDone(iovec *iov, Count &num, DataSize done) {
+  while (num > 0 && done >= static_cast<DataSize>(iov->iov_len)) {
+    done -= iov->iov_len;
+    ++iov;
+    --num;
+  }
+  if (num > 0) {
+    iov->iov_base = static_cast<BufUnit*>(iov->iov_base) + done;
+    iov->iov_len -= done;
+  }
+  return iov;
+}
+
+//Write all the buffers
+bool WriteVN(const int &fd, const Count &num, const iovec *iov) {
+  iovec local[kMaxIOVecNum];
+  Count remain = num > kMaxIOVecNum ? kMaxIOVecNum : num;
+  for (Count i = 0; i < remain; ++i) local[i] = iov[i];
+
+  iovec *cur = SkipDone(local, remain, 0);
+  while (remain > 0) {
+    auto s = writev(fd, cur, remain);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) return false;
+    cur = SkipDone(cur, remain, s);
+  }
+  return num <= kMaxIOVecNum || WriteVN(fd, num - kMaxIOVecNum,
+                                        iov + kMaxIOVecNum);
+}
+
+//Fill all the buffers
+bool ReadVN(const int &fd, const Count &num, const iovec *iov) {
+  iovec local[kMaxIOVecNum];
+  Count remain = num > kMaxIOVecNum ? kMaxIOVecNum : num;
+  for (Count i = 0; i < remain; ++i) local[i] = iov[i];
+
+  iovec *cur = SkipDone(local, remain, 0);
+  while (remain > 0) {
+    auto s = readv(fd, cur, remain);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) return false;
+    cur = SkipDone(cur, remain, s);
+  }
+  return num <= kMaxIOVecNum || ReadVN(fd, num - kMaxIOVecNum,
+                                       iov + kMaxIOVecNum);
+}
+
+//The header is held back by MSG_MORE so it leaves with the file's bytes
+bool SendFileN(const int &sock, const DataSize &head_size, void *head,
+               const int &fd, DataSize offset, DataSize size) {
+  auto *p = static_cast<BufUnit*>(head);
+  for (DataSize done = 0; done < head_size; ) {
+    auto s = send(sock, p + done, head_size - done, MSG_MORE);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) return false;
+    done += s;
+  }
+  while (size > 0) {
+    off_t off = offset;
+    auto s = sendfile(sock, fd, &off, size);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) return false;
+    offset += s;
+    size -= s;
+  }
+  return true;
+}
+
+} // namespace exr
@@ -0,0 +1,26 @@
+#ifndef EXR_DATA_ACCESS_VECTORIO_HH_
+#define EXR_DATA_ACCESS_VECTORIO_HH_
+
+#include <sys/uio.h>
+
+#include "util/typedef.hh"
+
+namespace exr {
+
+//Max number of buffers in one scatter/gather call
+const Count kMaxIOVecNum = 8;
+
+/* Write/read all the bytes of several buffers through one descriptor,
+   retrying on partial transfers. Return false if the peer is gone */
+bool WriteVN(const int &fd, const Count &num, const iovec *iov);
+bool ReadVN(const int &fd, const Count &num, const iovec *iov);
+
+/* Write a header and then size bytes of file fd from offset to a socket,
+   the file part goes by sendfile without passing through user space.
+   Return false if the peer is gone or the file is too short */
+bool SendFileN(const int &sock, const DataSize &head_size, void *head,
+               const int &fd, DataSize offset, DataSize size);
+
+} // namespace exr
+
+#endif // EXR_DATA_ACCESS_VECTORIO_HH_
@@ -0,0 +1,90 @@
+/* Class ChunkStore -- from "data/file/chunk_store.hh" */
+
+#include <fstream>
+#include <iostream>
+
+namespace exr {
+
+//Constructor and destructor
+template <typename File>
+ChunkStore<File>::ChunkStore() : direct_(false), indexed_(false) {}
+
+template <typename File>
+ChunkStore<File>::~ChunkStore() { Close(); }
+
+template <typename File>
+void ChunkStore<File>::SetSetup(Setup setup) { setup_ = std::move(setup); }
+
+//Load the index, the files are opened later by their chunks
+template <typename File>
+void ChunkStore<File>::Open(const Path &path, const bool &direct) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  path_ = path;
+  direct_ = direct;
+  index_.clear();
+  std::ifstream index_file(path + kChunkIndexEnd);
+  indexed_ = index_file.is_open();
+  if (!indexed_) return;
+
+  ChunkId chunk;
+  Extent e;
+  while (index_file >> chunk >> e.path >> e.offset >> e.size) {
+    if (e.offset < 0 || e.size < 0 || !index_.emplace(chunk, e).second) {
+      std::cerr << "Bad chunk " << chunk << " in the index of \"" << path
+                << "\"" << std::endl;
+      exit(-1);
+    }
+  }
+}
+
+template <typename File>
+File& ChunkStore<File>::Get(const ChunkId &chunk, DataSize &offset,
+                            const DataSize &size) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  const Path *path = &path_;
+  //Without an index the data file holds every chunk
+  if (indexed_) {
+    auto it = index_.find(chunk);
+    if (it == index_.end()) {
+      std::cerr << "Chunk " << chunk << " is not in the index of \""
+                << path_ << "\"" << std::endl;
+      exit(-1);
+    }
+    auto &e = it->second;
+    if (offset < 0 || offset + size > e.size) {
+      std::cerr << "Range " << offset << "+" << size << " is out of chunk "
+                << chunk << std::endl;
+      exit(-1);
+    }
+    path = &e.path;
+    offset += e.offset;
+  }
+
+  auto &file = files_[*path];
+  if (!file) {
+    file = std::make_unique<File>();
+    if (setup_) setup_(*file);
+    file->Open(*path, direct_);
+  }
+  return *file;
+}
+
+template <typename File>
+void ChunkStore<File>::ForEach(const std::function<void(File &file)> &f) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  for (auto &file : files_) f(*file.second);
+}
+
+template <typename File>
+void ChunkStore<File>::Close() {
+  std::unique_lock<std::mutex> lck(mtx_);
+  files_.clear();
+}
+
+template <typename File>
+DataSize ChunkStore<File>::chunk_num() {
+  std::unique_lock<std::mutex> lck(mtx_);
+  return index_.size();
+}
+
+} // namespace exr
@@ -0,0 +1,68 @@
+#ifndef EXR_DATA_FILE_CHUNKSTORE_HH_
+#define EXR_DATA_FILE_CHUNKSTORE_HH_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "util/typedef.hh"
+
+namespace exr {
+
+//An index next to the node's data file lists its chunks, a line each:
+//  {chunk_id} {file} {offset} {size}
+const Path kChunkIndexEnd = ".idx";
+
+/* The chunks a node keeps, each an extent of some file: a whole file of
+   its own or a range of a big one. The index is loaded once and kept in
+   memory, a file is opened by the first chunk in it and then shared by
+   all of them. A node without an index keeps every chunk in its data
+   file, as with a single file. With one, a chunk not in it is an error */
+template <typename File>
+class ChunkStore
+{
+ public:
+  ChunkStore();
+  ~ChunkStore();
+
+  //Called on every file before it is opened, like to give it a ring
+  using Setup = std::function<void(File &file)>;
+  void SetSetup(Setup setup);
+
+  //path: the node's data file, with the index at path + kChunkIndexEnd
+  void Open(const Path &path, const bool &direct = false);
+  //The file of a chunk, safe from several threads. offset is moved from
+  //  the chunk into the file, size bytes from it must be in the chunk
+  File& Get(const ChunkId &chunk, DataSize &offset, const DataSize &size);
+  //Every file opened
+  void ForEach(const std::function<void(File &file)> &f);
+  void Close();
+
+  DataSize chunk_num();
+
+  //ChunkStore is neither copyable nor movable
+  ChunkStore(const ChunkStore&) = delete;
+  ChunkStore& operator=(const ChunkStore&) = delete;
+
+ private:
+  struct Extent {
+    Path path;
+    DataSize offset;
+    DataSize size;
+  };
+
+  Path path_;
+  bool direct_;
+  bool indexed_;
+  Setup setup_;
+  std::unordered_map<ChunkId, Extent> index_;
+  std::unordered_map<Path, std::unique_ptr<File>> files_;
+  std::mutex mtx_;
+};
+
+} // namespace exr
+
+#include "data/file/chunk_store-inl.hh"
+
+#endif // EXR_DATA_FILE_CHUNKSTORE_HH_
@@ -1,41 +1,126 @@
 #include "data/file/file_reader.hh"
 
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 namespace exr {
 
 //Constructor and destructor
-FileReader::FileReader() = default;
+FileReader::FileReader()
+    : ring_(nullptr), fd_(-1), direct_fd_(-1), offset_(0) {}
 
 FileReader::~FileReader() { Close(); }
 
+void FileReader::UseRing(IORing *ring) { ring_ = ring; }
+
 //Open a file
-void FileReader::Open(const Path &path) {
+void FileReader::Open(const Path &path, const bool &direct) {
   //Close the file if has opened
-  if (in_.is_open()) Close();
+  if (is_open()) Close();
 
-  //Try to open the new file
-  in_ = std::fstream(path, std::ios::in | std::ios::binary);
-  if (!in_.is_open()) {
+  fd_ = open(path.c_str(), O_RDONLY);
+  offset_ = 0;
+  if (fd_ < 0) {
     std::cerr << "Open file \"" << path << "\" error" << std::endl;
     exit(-1);
   }
+  //A file system without direct I/O keeps to the cache
+  if (direct) direct_fd_ = open(path.c_str(), O_RDONLY | O_DIRECT);
 }
 
 //Jump to a place to read
-void FileReader::SetOffset(const DataSize &offset) {
-  in_.seekg(offset, std::ios::beg);
-}
+void FileReader::SetOffset(const DataSize &offset) { offset_ = offset; }
 
 //Read data
 DataSize FileReader::Read(const DataSize &size, void *buf) {
-  in_.read(static_cast<BufUnit*>(buf), size);
-  return in_.gcount();
+  auto got = ring_ ? ReadPiecesAt(ring_, offset_, size, size, buf) :
+                     ReadAt(offset_, size, buf);
+  offset_ += got;
+  return got;
+}
+
+DataSize FileReader::ReadPieces(const DataSize &size,
+                                const DataSize &piece_size, void *buf) {
+  auto got = ReadPiecesAt(ring_, offset_, size, piece_size, buf);
+  offset_ += got;
+  return got;
 }
 
 //Close the file
 void FileReader::Close() {
-  if (in_.is_open()) in_.close();
+  if (direct_fd_ >= 0) {
+    close(direct_fd_);
+    direct_fd_ = -1;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+DataSize FileReader::ReadAt(const DataSize &offset, const DataSize &size,
+                            void *buf) {
+  auto fd = Pick_(offset, size, buf);
+  DataSize got = 0;
+  while (got < size) {
+    auto s = pread(fd, static_cast<BufUnit*>(buf) + got, size - got,
+                   offset + got);
+    if (s < 0 && errno == EINTR) continue;
+    if (s <= 0) break;
+    got += s;
+  }
+  return got;
+}
+
+//Every piece is one op, the whole range goes to the kernel in one batch
+DataSize FileReader::ReadPiecesAt(IORing *ring, const DataSize &offset,
+                                  const DataSize &size,
+                                  const DataSize &piece_size, void *buf) {
+  if (!ring) return ReadAt(offset, size, buf);
+
+  std::vector<IORing::Op> ops;
+  auto *p = static_cast<BufUnit*>(buf);
+  for (DataSize done = 0; done < size; done += piece_size) {
+    auto len = size - done < piece_size ? size - done : piece_size;
+    ops.push_back({false, Pick_(offset + done, len, p + done), offset + done,
+                   1, {{p + done, static_cast<size_t>(len)}}, 0});
+  }
+  if (!ring->Submit(ops.size(), ops.data())) {
+    std::cerr << "Read file through io_uring error" << std::endl;
+    exit(-1);
+  }
+
+  //A short piece means the end of the file, nothing behind it counts
+  DataSize got = 0;
+  for (auto &op : ops) {
+    got += op.done;
+    if (got < size && op.done < piece_size) break;
+  }
+  return got;
+}
+
+int FileReader::handle() { return fd_; }
+
+bool FileReader::is_open() { return fd_ >= 0; }
+
+DataSize FileReader::file_size() {
+  struct stat st;
+  return fd_ >= 0 && fstat(fd_, &st) == 0 ? st.st_size : 0;
+}
+
+//Direct I/O only takes whole aligned blocks
+int FileReader::Pick_(const DataSize &offset, const DataSize &size,
+                      const void *buf) {
+  if (direct_fd_ >= 0 && offset % kDirectAlign == 0 &&
+      size % kDirectAlign == 0 &&
+      reinterpret_cast<uintptr_t>(buf) % kDirectAlign == 0)
+    return direct_fd_;
+  return fd_;
 }
 
 } // namespace exr
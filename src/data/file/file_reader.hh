@@ -1,31 +1,60 @@
 #ifndef EXR_DATA_FILE_FILEREADER_HH_
 #define EXR_DATA_FILE_FILEREADER_HH_
 
-#include <fstream>
-
+#include "util/io_ring.hh"
 #include "util/typedef.hh"
 
 namespace exr {
 
-/* Local file Reader */
+//Buffers, offsets and sizes of direct I/O are multiples of this
+const DataSize kDirectAlign = 4096;
+
+/* Local file Reader on a plain descriptor. Reads are positional, so one
+   reader opened for the node can be shared by all the loading threads.
+   Opened direct, the aligned reads skip the page cache and the others go
+   through a second, cached descriptor */
 class FileReader
 {
  public:
   FileReader();
   ~FileReader();
 
-  //File reading...
-  void Open(const Path &path);
+  //Read through io_uring, set before Open
+  void UseRing(IORing *ring);
+
+  //File reading, from a position kept by the reader
+  void Open(const Path &path, const bool &direct = false);
   void SetOffset(const DataSize &offset);
   DataSize Read(const DataSize &size, void *buf);
+  //Read size bytes as pieces of piece_size, submitted together on a ring
+  DataSize ReadPieces(const DataSize &size, const DataSize &piece_size,
+                      void *buf);
   void Close();
 
+  //The same at explicit positions, safe from several threads. A ring may
+  //  be given for every call, nullptr reads by pread
+  DataSize ReadAt(const DataSize &offset, const DataSize &size, void *buf);
+  DataSize ReadPiecesAt(IORing *ring, const DataSize &offset,
+                        const DataSize &size, const DataSize &piece_size,
+                        void *buf);
+
+  //The cached descriptor, -1 if not opened
+  int handle();
+  bool is_open();
+  //Bytes of the opened file
+  DataSize file_size();
+
   //FileReader is neither copyable nor movable
   FileReader(const FileReader&) = delete;
   FileReader& operator=(const FileReader&) = delete;
 
  private:
-  std::fstream in_;
+  IORing *ring_;
+  int fd_;
+  int direct_fd_;
+  DataSize offset_;
+
+  int Pick_(const DataSize &offset, const DataSize &size, const void *buf);
 };
 
 } // namespace exr
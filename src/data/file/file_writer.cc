@@ -1,47 +1,98 @@
 #include "data/file/file_writer.hh"
 
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
 #include <iostream>
+#include <unistd.h>
+
+#include "data/file/file_reader.hh"
 
 namespace exr {
 
 //Constructor and destructor
-FileWriter::FileWriter() = default;
+FileWriter::FileWriter()
+    : ring_(nullptr), fd_(-1), direct_fd_(-1), writeback_(false) {}
+
+FileWriter::~FileWriter() { if (is_open()) Close(); }
+
+void FileWriter::UseRing(IORing *ring) { ring_ = ring; }
 
-FileWriter::~FileWriter() { if (out_.is_open()) Close(); }
+void FileWriter::UseWriteback() { writeback_ = true; }
 
 //Open a file
-void FileWriter::Open(const Path &path) {
+void FileWriter::Open(const Path &path, const bool &direct) {
   //Close the file if has opened
-  if (out_.is_open()) Close();
+  if (is_open()) Close();
 
-  //Create a new file if doesn't exist'
-  if (system(("touch " + path).c_str()) == -1) {
-    std::cerr << "Create file \"" << path << "\" error" << std::endl;
-    exit(-1);
-  }
-
-  //Try to open the new file
-  out_ = std::fstream(path, std::ios::out | std::ios::in |
-                            std::ios::binary);
-  if (!out_.is_open()) {
+  fd_ = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd_ < 0) {
     std::cerr << "Open file \"" << path << "\" error" << std::endl;
     exit(-1);
   }
+  if (direct) direct_fd_ = open(path.c_str(), O_WRONLY | O_DIRECT);
 }
 
 //Write data
 void FileWriter::Write(const DataSize &offset, const DataSize &size,
                        void *buf) {
-  out_.seekg(offset, std::ios::beg);
-  out_.write(static_cast<BufUnit*>(buf), size);
+  auto fd = fd_;
+  if (direct_fd_ >= 0 && offset % kDirectAlign == 0 &&
+      size % kDirectAlign == 0 &&
+      reinterpret_cast<uintptr_t>(buf) % kDirectAlign == 0)
+    fd = direct_fd_;
+
+  if (ring_) {
+    IORing::Op op{true, fd, offset, 1,
+                  {{buf, static_cast<size_t>(size)}}, 0};
+    if (!ring_->Submit(1, &op)) {
+      std::cerr << "Write file through io_uring error" << std::endl;
+      exit(-1);
+    }
+  } else {
+    for (DataSize done = 0; done < size;) {
+      auto s = pwrite(fd, static_cast<BufUnit*>(buf) + done, size - done,
+                      offset + done);
+      if (s < 0 && errno == EINTR) continue;
+      if (s <= 0) {
+        std::cerr << "Write file error" << std::endl;
+        exit(-1);
+      }
+      done += s;
+    }
+  }
+
+  //Only started, the write doesn't wait for the disk
+  if (writeback_ && fd == fd_)
+    sync_file_range(fd_, offset, size, SYNC_FILE_RANGE_WRITE);
+}
+
+//File systems without fallocate just allocate at writing
+void FileWriter::Preallocate(const DataSize &offset, const DataSize &size) {
+  if (fd_ >= 0 && size > 0) fallocate(fd_, 0, offset, size);
+}
+
+//Direct writes skip the cache but not the metadata or the disk's cache
+void FileWriter::Sync() {
+  if (fd_ >= 0 && fdatasync(fd_) != 0) {
+    std::cerr << "Flush file error" << std::endl;
+    exit(-1);
+  }
 }
 
 //Close and save the file
 void FileWriter::Close() {
-  out_.close();
+  if (direct_fd_ >= 0) {
+    close(direct_fd_);
+    direct_fd_ = -1;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
 }
 
 //Check if the file is opened
-bool FileWriter::is_open() { return out_.is_open(); }
+bool FileWriter::is_open() { return fd_ >= 0; }
 
 } // namespace exr
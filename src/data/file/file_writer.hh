@@ -1,23 +1,33 @@
 #ifndef EXR_DATA_FILE_FILEWRITER_HH_
 #define EXR_DATA_FILE_FILEWRITER_HH_
 
-#include <fstream>
-#include <memory>
-
+#include "util/io_ring.hh"
 #include "util/typedef.hh"
 
 namespace exr {
 
-/* Local file writer */
+/* Local file writer on a plain descriptor. Writes are positional, so
+   pieces of different tasks are stored at once without a lock. Opened
+   direct, the aligned writes skip the page cache */
 class FileWriter
 {
  public:
   FileWriter();
   ~FileWriter();
 
-  //File writing
-  void Open(const Path &path);
+  //Write through io_uring, set before Open
+  void UseRing(IORing *ring);
+  //Start the writeback of every piece written through the cache at once,
+  //  so dirty pages don't pile up until the end
+  void UseWriteback();
+
+  //File writing, the file is created if it doesn't exist
+  void Open(const Path &path, const bool &direct = false);
   void Write(const DataSize &offset, const DataSize &size, void *buf);
+  //Allocate the blocks of a range before its pieces come
+  void Preallocate(const DataSize &offset, const DataSize &size);
+  //Wait until what is written is on the disk
+  void Sync();
   void Close();
   bool is_open();
 
@@ -26,7 +36,10 @@ class FileWriter
   FileWriter& operator=(const FileWriter&) = delete;
 
  private:
-  std::fstream out_;
+  IORing *ring_;
+  int fd_;
+  int direct_fd_;
+  bool writeback_;
 };
 
 } // namespace exr
@@ -0,0 +1,51 @@
+#include "data/file/prefetcher.hh"
+
+#include <algorithm>
+#include <iostream>
+
+namespace exr {
+
+//Constructor and destructor
+Prefetcher::Prefetcher(FileReader &file, IORing *ring, const DataSize &offset,
+                       const DataSize &size, const DataSize &piece_size,
+                       BufUnit *buf, const Count &depth)
+    : file_(file), ring_(ring), offset_(offset), size_(size),
+      piece_size_(piece_size), buf_(buf), ahead_(depth * piece_size),
+      read_(0), used_(0), thr_([this] { Run_(); }) {}
+
+//The user always waits for the whole range first
+Prefetcher::~Prefetcher() { thr_.join(); }
+
+void Prefetcher::Wait(const DataSize &end) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  cv_.wait(lck, [&] { return read_ >= std::min(end, size_); });
+}
+
+void Prefetcher::Use(const DataSize &end) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  used_ = end;
+  cv_.notify_all();
+}
+
+//Every free room is filled at once, as one batch on a ring
+void Prefetcher::Run_() {
+  std::unique_lock<std::mutex> lck(mtx_);
+  while (read_ < size_) {
+    cv_.wait(lck, [&] { return read_ - used_ < ahead_; });
+    auto from = read_;
+    auto len = std::min(size_, used_ + ahead_) - from;
+    lck.unlock();
+
+    if (file_.ReadPiecesAt(ring_, offset_ + from, len, piece_size_,
+                           buf_ + from) != len) {
+      std::cerr << "File is not big enough for reading..." << std::endl;
+      exit(-1);
+    }
+
+    lck.lock();
+    read_ += len;
+    cv_.notify_all();
+  }
+}
+
+} // namespace exr
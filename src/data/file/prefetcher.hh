@@ -0,0 +1,57 @@
+#ifndef EXR_DATA_FILE_PREFETCHER_HH_
+#define EXR_DATA_FILE_PREFETCHER_HH_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "data/file/file_reader.hh"
+#include "util/io_ring.hh"
+#include "util/typedef.hh"
+
+namespace exr {
+
+//Pieces read ahead of the ones in use
+const Count kReadAhead = 8;
+
+/* Reads a range of a file into buf by its own thread, keeping up to depth
+   pieces ahead of the user, so the disk works while the pieces before are
+   multiplied and sent. A short file is an error, as for other loads */
+class Prefetcher
+{
+ public:
+  Prefetcher(FileReader &file, IORing *ring, const DataSize &offset,
+             const DataSize &size, const DataSize &piece_size, BufUnit *buf,
+             const Count &depth = kReadAhead);
+  ~Prefetcher();
+
+  //Wait until the first end bytes of the range are in buf
+  void Wait(const DataSize &end);
+  //The first end bytes are used, the room behind them can be read
+  void Use(const DataSize &end);
+
+  //Prefetcher is neither copyable nor movable
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+
+ private:
+  FileReader &file_;
+  IORing *ring_;
+  DataSize offset_;
+  DataSize size_;
+  DataSize piece_size_;
+  BufUnit *buf_;
+  DataSize ahead_; //Bytes which may be read but not used yet
+
+  DataSize read_;
+  DataSize used_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::thread thr_;
+
+  void Run_();
+};
+
+} // namespace exr
+
+#endif // EXR_DATA_FILE_PREFETCHER_HH_
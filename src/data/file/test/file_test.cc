@@ -1,8 +1,15 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
 
+#include "data/file/chunk_store.hh"
 #include "data/file/file_reader.hh"
 #include "data/file/file_writer.hh"
+#include "data/file/prefetcher.hh"
+#include "util/io_ring.hh"
 #include "util/typedef.hh"
 
 int main()
@@ -53,6 +60,108 @@ int main()
   std::cout.write(b, s);
   std::cout << "\"" << std::endl << std::endl;
 
+  //Read pieces through io_uring
+  if (exr::IORing::Supported()) {
+    exr::IORing ring(4);
+    exr::FileReader ring_reader;
+    ring_reader.UseRing(&ring);
+    ring_reader.Open(path);
+    offset = 0;
+    ring_reader.SetOffset(offset);
+    char c[100] = "";
+    s = ring_reader.ReadPieces(5 + size, 4, c);
+    std::cout << "Ring read from: \"" << path << "\"" << std::endl
+              << "    piece size: " << 4 << std::endl
+              << "   actual size: " << s << std::endl
+              << "  with content: \"";
+    std::cout.write(c + 5, s - 5);
+    std::cout << "\"" << std::endl << std::endl;
+  } else {
+    std::cout << "io_uring unavailable, ring reading skipped"
+              << std::endl << std::endl;
+  }
+
+  //Aligned pieces through direct I/O, the rest through the cache
+  exr::Path dpath = "src/data/file/test/file_test_direct.txt";
+  auto *d = static_cast<char*>(aligned_alloc(exr::kDirectAlign,
+                                             2 * exr::kDirectAlign));
+  for (exr::DataSize i = 0; i < 2 * exr::kDirectAlign; ++i) d[i] = 'a' + i % 26;
+  exr::FileWriter dwriter;
+  dwriter.Open(dpath, true);
+  dwriter.Write(0, 2 * exr::kDirectAlign, d);
+  dwriter.Write(2 * exr::kDirectAlign, size, a);
+  dwriter.Close();
+  exr::FileReader dreader;
+  dreader.Open(dpath, true);
+  char e[100] = "";
+  s = dreader.ReadAt(exr::kDirectAlign, exr::kDirectAlign, d);
+  auto t = dreader.ReadAt(2 * exr::kDirectAlign, size, e);
+  std::cout << "Direct read from: \"" << dpath << "\"" << std::endl
+            << "  aligned piece: " << s << " bytes, \"";
+  std::cout.write(d, 8);
+  std::cout << "...\"" << std::endl
+            << "     tail piece: " << t << " bytes, \"";
+  std::cout.write(e, t);
+  std::cout << "\"" << std::endl << std::endl;
+  free(d);
+
+  //Pieces read ahead while the ones before are used
+  {
+    exr::FileReader preader;
+    preader.Open(path);
+    char f[100] = "";
+    exr::Prefetcher pf(preader, nullptr, 5, size, 3, f, 2);
+    std::cout << "Prefetched from: \"" << path << "\"" << std::endl
+              << "     pieces of: " << 3 << ", 2 ahead" << std::endl;
+    for (exr::DataSize done = 0; done < size; done += 3) {
+      auto end = std::min(done + 3, size);
+      pf.Wait(end);
+      std::cout << "         piece: \"";
+      std::cout.write(f + done, end - done);
+      std::cout << "\"" << std::endl;
+      pf.Use(end);
+    }
+    std::cout << std::endl;
+  }
+
+  //Chunks as extents of one file, found by the index of another
+  {
+    auto cpath = path;
+    std::ofstream index(cpath + exr::kChunkIndexEnd);
+    index << "1 " << dpath << " 100 14" << std::endl
+          << "2 " << dpath << " 200 14" << std::endl;
+    index.close();
+    exr::ChunkStore<exr::FileWriter> wstore;
+    wstore.Open(cpath);
+    for (exr::ChunkId chunk = 1; chunk <= 2; ++chunk) {
+      exr::DataSize at = 0;
+      a[0] = '0' + chunk;
+      wstore.Get(chunk, at, size).Write(at, size, a);
+    }
+    wstore.Close();
+    exr::ChunkStore<exr::FileReader> rstore;
+    rstore.Open(cpath);
+    std::cout << "Chunks indexed: " << rstore.chunk_num() << std::endl;
+    for (exr::ChunkId chunk = 1; chunk <= 2; ++chunk) {
+      char g[100] = "";
+      exr::DataSize at = 0;
+      s = rstore.Get(chunk, at, size).ReadAt(at, size, g);
+      std::cout << "      chunk " << chunk << ": at " << at << " of \""
+                << dpath << "\", \"";
+      std::cout.write(g, s);
+      std::cout << "\"" << std::endl;
+    }
+    rstore.Close();
+    std::remove((cpath + exr::kChunkIndexEnd).c_str());
+    //Without an index, any chunk is the data file itself
+    exr::ChunkStore<exr::FileReader> fstore;
+    fstore.Open(cpath);
+    exr::DataSize at = 5;
+    fstore.Get(3, at, size);
+    std::cout << "      chunk 3: at " << at << " of \"" << cpath << "\""
+              << std::endl << std::endl;
+  }
+
   std::cout << "Test ended." << std::endl;
   return 0;
 }
@@ -7,6 +7,7 @@
 #include "config/alg_loader.hh"
 #include "config/config_reader.hh"
 #include "task/controller.hh"
+#include "util/memory_pool.hh"
 
 using exr::Count;
 using exr::Time;
@@ -15,6 +16,7 @@ using exr::ConfigReader;
 using exr::AddressReader;
 using exr::Controller;
 using exr::AlgLoader;
+using exr::MemoryPool;
 
 /* The main function of the master node */
 int main(int argc, char *argv[])
@@ -43,9 +45,12 @@ int main(int argc, char *argv[])
 
   //Create the controller and connect to other nodes
   std::cout << "Creating and initializing the controller..." << std::endl;
-  Controller con(ar.get_total(), cr.get_size(), cr.get_psize());
+  Controller con(ar.get_total(), cr.get_size(), cr.get_psize(),
+                 cr.get_window(),
+                 MemoryPool::Lanes(cr.get_mem_num(), ar.get_total()));
   con.Connect(ar.GetAddresses());
-  std::cout << "Connected" << std::endl << std::endl;
+  std::cout << "Connected in " << con.connect_time() << " ms"
+            << std::endl << std::endl;
 
   //Run tasks
   struct timeval time_a, time_b, time_c, time_d;
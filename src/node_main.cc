@@ -40,12 +40,16 @@ int main(int argc, char *argv[])
               cr.get_mem_num(), cr.get_mem_size(),
               cr.get_bw_conf_path(), cr.get_eth_name(),
               cr.get_if_print(), cr.get_recv_thr_num(),
-              cr.get_comp_thr_num(), cr.get_proc_thr_num());
+              cr.get_comp_thr_num(), cr.get_proc_thr_num(),
+              cr.get_transport(), cr.get_link_num(), cr.get_direct_io(),
+              cr.get_writeback(), cr.get_durability(), cr.get_flush_ms(),
+              cr.get_shm_lend());
 
   //Connect to other nodes
   std::cout << "Connecting to the other nodes and starting to repair"
             << std::endl;
   nr.Prepare(ar.GetAddresses());
+  std::cout << "Mesh formed in " << nr.connect_time() << " ms" << std::endl;
 
 
   //Wait for the tasks to be finished
@@ -53,5 +57,9 @@ int main(int argc, char *argv[])
   std::cout << std::endl
             << "Received the closing signal, all tasks compeleted"
             << std::endl;
+  auto fs = nr.flush_stats();
+  if (fs.num > 0)
+    std::cout << "Flushed " << fs.num << " times, " << fs.total / fs.num
+              << " ms on average, " << fs.max << " ms at most" << std::endl;
   return 0;
 }
@@ -8,89 +8,115 @@ namespace exr {
 //Constructor and destructor
 ComputeProcessor::ComputeProcessor(const Count &thr_n, MemoryPool &mp,
                                    DataProcessor<DataPiece> &next_prc)
-    : DataProcessor<DataPiece>(1, thr_n), mp_(mp), next_prc_(next_prc),
-      rc_(2, 1) {
-  RSUnit coefs[2] = {1, 1};
-  rc_.InitForEncode(coefs);
-}
+    : DataProcessor<DataPiece>(thr_n, 1), mp_(mp), next_prc_(next_prc),
+      shards_(std::make_unique<ComputeShard[]>(thr_n)) {}
 
 ComputeProcessor::~ComputeProcessor() { Close(); }
 
-//Distribute
-Count ComputeProcessor::Distribute(const DataPiece &data) { return 0; }
+void ComputeProcessor::SetReleaser(Releaser releaser) {
+  releaser_ = std::move(releaser);
+}
+
+//Distribute: all the pieces of a task go to the same queue
+Count ComputeProcessor::Distribute(const DataPiece &data) {
+  return data.task_id % queue_n_;
+}
 
 //Process the data
 void ComputeProcessor::Process(DataPiece data, Count qid) {
   //Get Group, create one if not exist
+  auto &shard = shards_[qid];
   auto task_id = data.task_id;
   auto size = data.size;
-  std::unique_lock<std::mutex> lck(mtx_);
-  auto &pg = task_pieces_[task_id];
-  lck.unlock();
+  auto src_id = data.src_id;
+  auto &pg = shard.tasks[task_id];
 
   //Deal with the content
   if (!(data.buf) && size > 0) {
     //Task info
     next_prc_.PushData(std::move(data));
     size = 0 - size;
-  } else if (!AddPiece_(pg, std::move(data))) {
+  } else if (!AddPiece_(shard, pg, std::move(data))) {
     //Data piece not sended out
     size = 0;
   }
+  if (src_id > 0 && releaser_) releaser_(src_id);
 
   //Check if task ended
-  std::unique_lock<std::mutex> rlck(pg.remain_mtx);
   if (size < 0)
     pg.total = 0 - size;
   else
     pg.sum += size;
-  if (pg.sum == pg.total && pg.total > 0) {
-    rlck.unlock();
-    lck.lock();
-    task_pieces_.erase(task_id);
-  }
+  if (pg.sum == pg.total && pg.total > 0) shard.tasks.erase(task_id);
 }
 
-bool ComputeProcessor::AddPiece_(PieceGroup &pg, DataPiece data) {
+bool ComputeProcessor::AddPiece_(ComputeShard &shard, PieceGroup &pg,
+                                 DataPiece data) {
   //Get piece, create one if not exist
   auto offset = data.offset;
-  std::unique_lock<std::mutex> glck(pg.map_mtx);
-  auto &ptp = pg.pieces[offset];
-  if (!ptp) {
-    ptp = std::make_unique<TempPiece>(std::move(data), 0);
-    ptp->temp_buf = mp_.Get(0, offset);
-    glck.unlock();
-  } else {
-    glck.unlock();
-    //XOR two pieces and gather the infomation
-    std::unique_lock<std::mutex> plck(ptp->mtx);
-    ptp->dp.tar_id += data.tar_id;
-    ptp->dp.delay_time += data.delay_time;
-    if (!(ptp->dp.buf)) {
-      ptp->dp.size = data.size;
-      ptp->dp.buf = data.buf;
-    } else if (data.buf) {
-      BufUnit *srcs[2] = {ptp->dp.buf, data.buf},
-              *tars[1] = {ptp->temp_buf};
-      rc_.Encode(data.size, srcs, tars);
-      ptp->dp.buf = ptp->temp_buf;
-      ptp->temp_buf = data.buf;
-    }
-    plck.unlock();
+  auto &slot = pg.pieces[offset];
+  if (!slot) {
+    slot = NewPiece_(shard);
+    slot->dp = data;
+    slot->temp_buf = mp_.Get(data.task_id, 0, offset);
+  }
+  auto *tp = slot;
+
+  //Gather the infomation, the data is only kept aside for now
+  if (tp->num > 0) {
+    tp->dp.tar_id += data.tar_id;
+    tp->dp.delay_time += data.delay_time;
   }
+  if (data.buf) {
+    tp->dp.size = data.size;
+    tp->bufs.push_back(data.buf);
+    tp->coefs.push_back(data.coef);
+  }
+  ++(tp->num);
+  tp->src_num += data.src_num;
+  if (tp->src_num != tp->num) return false;
+
+  //All the contributions are here, combine them at once
+  Combine_(*tp);
+  next_prc_.PushData(std::move(tp->dp));
+  pg.pieces.erase(offset);
+  shard.spare.push_back(tp);
+  return true;
+}
 
-  //Check if need to send the data out
-  std::unique_lock<std::mutex> plck(ptp->mtx);
-  ++(ptp->num);
-  ptp->src_num += data.src_num;
-  if (ptp->src_num == ptp->num) {
-    next_prc_.PushData(std::move(ptp->dp));
-    plck.unlock();
-    glck.lock();
-    pg.pieces.erase(offset);
-    return true;
+//Reuse a piece combined before, its vectors keep their capacity
+TempPiece* ComputeProcessor::NewPiece_(ComputeShard &shard) {
+  if (shard.spare.empty()) {
+    shard.store.push_back(std::make_unique<TempPiece>());
+    return shard.store.back().get();
   }
-  return false;
+  auto *tp = shard.spare.back();
+  shard.spare.pop_back();
+  tp->num = 0;
+  tp->src_num = 0;
+  tp->bufs.clear();
+  tp->coefs.clear();
+  return tp;
+}
+
+//Contributions already multiplied count as multiplied by one
+void ComputeProcessor::Combine_(TempPiece &tp) {
+  auto &dp = tp.dp;
+  dp.coef = 0;
+  if (tp.bufs.empty()) return;
+  if (tp.bufs.size() == 1 && tp.coefs[0] <= 1) {
+    dp.buf = tp.bufs[0];
+    return;
+  }
+
+  for (auto &c : tp.coefs)
+    if (c == 0) c = 1;
+  mp_.Place(tp.temp_buf, dp.size);
+  RSComputer::Combine(dp.size, tp.bufs.size(), tp.bufs.data(),
+                      tp.coefs.data(), tp.temp_buf);
+  dp.buf = tp.temp_buf;
+  //The contributions live on only in the result
+  for (auto *buf : tp.bufs) mp_.Release(buf, dp.size);
 }
 
 } // namespace exr
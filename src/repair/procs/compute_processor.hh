@@ -1,9 +1,10 @@
 #ifndef EXR_REPAIR_PROCS_COMPUTEPROCESSOR_HH_
 #define EXR_REPAIR_PROCS_COMPUTEPROCESSOR_HH_
 
+#include <functional>
 #include <memory>
-#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "repair/procs/data_processor.hh"
 #include "util/memory_pool.hh"
@@ -13,26 +14,38 @@
 
 namespace exr {
 
+//Contributions to one piece of a task, combined once all of them arrived
 struct TempPiece {
   DataPiece dp;
   Count num;
   Count src_num;
   BufUnit *temp_buf;
-  std::mutex mtx;
-  TempPiece(DataPiece _dp, const Count &_num)
-    : dp(std::move(_dp)), num(_num), src_num(0), temp_buf(nullptr) {}
+  std::vector<BufUnit*> bufs;
+  std::vector<RSUnit> coefs; //Of bufs, the local one may need multiplying
+  TempPiece() : dp{}, num(0), src_num(0), temp_buf(nullptr) {}
 };
 
+//Pieces of a task being assembled, by offset
 struct PieceGroup {
-  std::unordered_map<DataSize, std::unique_ptr<TempPiece>> pieces;
-  std::mutex map_mtx;
+  std::unordered_map<DataSize, TempPiece*> pieces;
   DataSize sum;
   DataSize total;
-  std::mutex remain_mtx;
   PieceGroup() : sum(0), total(0) {}
 };
 
-/* A Processor that can collect data pieces and encode */
+//The tasks of one queue, only touched by the thread of that queue. Pieces
+//  combined are kept for reuse instead of being freed
+struct ComputeShard {
+  std::unordered_map<Count, PieceGroup> tasks;
+  std::vector<std::unique_ptr<TempPiece>> store;
+  std::vector<TempPiece*> spare;
+};
+
+/* A Processor that can collect data pieces and encode. Pieces from the
+   network are already multiplied by their senders and are XORed in one
+   pass, the local piece is multiplied and accumulated into that result.
+   Tasks are sharded over the queues by id, one thread a queue, so a task
+   is assembled by a single thread without any lock */
 class ComputeProcessor : public DataProcessor<DataPiece>
 {
  public:
@@ -40,6 +53,10 @@ class ComputeProcessor : public DataProcessor<DataPiece>
                    DataProcessor<DataPiece> &next_prc);
   ~ComputeProcessor();
 
+  //Called with the source of every network piece once it is processed
+  using Releaser = std::function<void(const Count &src_id)>;
+  void SetReleaser(Releaser releaser);
+
   //ComputeProcessor is neither copyable nor movable
   ComputeProcessor(const ComputeProcessor&) = delete;
   ComputeProcessor& operator=(const ComputeProcessor&) = delete;
@@ -52,11 +69,13 @@ class ComputeProcessor : public DataProcessor<DataPiece>
   MemoryPool &mp_;
   DataProcessor<DataPiece> &next_prc_;
 
-  RSComputer rc_;
-  std::unordered_map<Count, PieceGroup> task_pieces_;
-  std::mutex mtx_;
+  Releaser releaser_;
+
+  std::unique_ptr<ComputeShard[]> shards_;
 
-  bool AddPiece_(PieceGroup &pg, DataPiece data);
+  bool AddPiece_(ComputeShard &shard, PieceGroup &pg, DataPiece data);
+  TempPiece* NewPiece_(ComputeShard &shard);
+  void Combine_(TempPiece &tp);
 };
 
 } // namespace exr
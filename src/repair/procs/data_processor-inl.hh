@@ -7,7 +7,8 @@ template <typename Data>
 DataProcessor<Data>::DataProcessor(const Count &queue_n, const Count &thr_n)
     : queue_n_(queue_n), on_run_(false),
       data_queues_(new WaitingQueue<Data>[queue_n]),
-      thr_n_(thr_n), threads_(new std::thread[queue_n * thr_n]) {}
+      thr_n_(thr_n), threads_(new std::thread[queue_n * thr_n]),
+      spread_(false) {}
 
 //Destructor
 template <typename Data>
@@ -22,6 +23,7 @@ void DataProcessor<Data>::Run() {
   for (Count i = 0; i < queue_n_; ++i) {
     for (Count j = 0; j < thr_n_; ++j) {
       threads_[i * thr_n_ + j] = std::thread([&, i] {
+        if (spread_) BindThread(i % NumaNodes());
         while (on_run_) {
           auto data = std::move(data_queues_[i].Pop());
           if (!on_run_) break;
@@ -32,6 +34,12 @@ void DataProcessor<Data>::Run() {
   }
 }
 
+//Only worth it with more than one node
+template <typename Data>
+void DataProcessor<Data>::SpreadOverNodes() {
+  spread_ = NumaNodes() > 1;
+}
+
 //Close the processor
 template <typename Data>
 void DataProcessor<Data>::Close() {
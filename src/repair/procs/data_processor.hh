@@ -4,6 +4,7 @@
 #include <memory>
 #include <thread>
 
+#include "util/numa.hh"
 #include "util/typedef.hh"
 #include "util/waiting_queue.hh"
 
@@ -23,6 +24,8 @@ class DataProcessor
   void Close();
   //Add a data into the processor
   void PushData(Data data);
+  //Run the threads of queue i on NUMA node i % nodes, set before Run
+  void SpreadOverNodes();
 
   //DataProcessor is neither copyable nor movable
   DataProcessor(const DataProcessor&) = delete;
@@ -41,6 +44,7 @@ class DataProcessor
   std::unique_ptr<WaitingQueue<Data>[]> data_queues_;
   Count thr_n_; //Number of threads
   std::unique_ptr<std::thread[]> threads_;
+  bool spread_; //Whether queues are bound to NUMA nodes
 };
 
 } // namespace exr
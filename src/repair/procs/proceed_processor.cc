@@ -1,5 +1,6 @@
 #include "repair/procs/proceed_processor.hh"
 
+#include <chrono>
 #include <sys/time.h>
 #include <thread>
 
@@ -12,19 +13,78 @@ ProceedProcessor::ProceedProcessor(const Count &id, const Count &total,
                                    const Count &thr_n, const Path &path,
                                    AccessCenter &ac)
     : DataProcessor<DataPiece>(thr_n, 1), id_(id), ac_(ac), path_(path),
+      direct_(false), writeback_(false), durability_(kNoDurability),
+      interval_ms_(0), dirty_(false), flushes_{0, 0, 0}, on_flush_(false),
+      ring_(nullptr),
       mtxs_(std::make_unique<std::mutex[]>(total)),
-      sizes_(std::make_unique<DataSize[]>(thr_n)) {
+      sizes_(std::make_unique<DataSize[]>(thr_n)),
+      pacers_(std::make_unique<TokenBucket[]>(thr_n)) {
   for (Count i = 0; i < thr_n; ++i) {
     sizes_[i] = 0;
     free_threads_.push(i);
   }
+  //Every file of the chunks is set up like the only one was
+  store_.SetSetup([&](FileWriter &file) {
+    if (ring_) file.UseRing(ring_);
+    if (writeback_) file.UseWriteback();
+  });
 }
 
 ProceedProcessor::~ProceedProcessor() {
-  writer_.Close();
+  if (flusher_.joinable()) {
+    std::unique_lock<std::mutex> lck(flush_mtx_);
+    on_flush_ = false;
+    flush_cv_.notify_all();
+    lck.unlock();
+    flusher_.join();
+  }
+  store_.Close();
   Close();
 }
 
+//Must be called before a file is opened by the first piece
+void ProceedProcessor::UseRing(IORing *ring) { ring_ = ring; }
+
+void ProceedProcessor::UseDirectIO() { direct_ = true; }
+
+void ProceedProcessor::UseWriteback() { writeback_ = true; }
+
+void ProceedProcessor::Expect(const RepairTask &rt) {
+  std::unique_lock<std::mutex> lck(mtxs_[0]);
+  places_[rt.task_id] = {rt.chunk, rt.offset, rt.size, nullptr, 0};
+}
+
+void ProceedProcessor::SetDurability(const Name &mode,
+                                     const Time &interval_ms) {
+  durability_ = mode;
+  interval_ms_ = interval_ms;
+  if (mode != kPeriodicDurability || interval_ms <= 0 || flusher_.joinable())
+    return;
+
+  on_flush_ = true;
+  flusher_ = std::thread([&] {
+    std::unique_lock<std::mutex> lck(flush_mtx_);
+    auto wait = std::chrono::microseconds(
+        static_cast<int64_t>(interval_ms_ * 1000));
+    while (on_flush_) {
+      flush_cv_.wait_for(lck, wait);
+      if (!on_flush_ || !dirty_) continue;
+      lck.unlock();
+      Flush_();
+      lck.lock();
+    }
+  });
+}
+
+FlushStats ProceedProcessor::flush_stats() {
+  std::unique_lock<std::mutex> lck(flush_mtx_);
+  return flushes_;
+}
+
+void ProceedProcessor::SetReleaser(Releaser releaser) {
+  releaser_ = std::move(releaser);
+}
+
 //Distribute
 Count ProceedProcessor::Distribute(const DataPiece &data) {
   std::unique_lock<std::mutex> lck(mtxs_[0]);
@@ -45,10 +105,12 @@ Count ProceedProcessor::Distribute(const DataPiece &data) {
 void ProceedProcessor::Process(DataPiece data, Count qid) {
   //Store or send data
   if (data.buf) {
-    if (data.tar_id == id_)
+    if (data.tar_id == id_) {
       Store_(data);
-    else
-      Send_(data);
+      if (releaser_) releaser_(data.buf, data.size);
+    } else {
+      Send_(data, qid);
+    }
     sizes_[qid] -= data.size;
   } else {
     sizes_[qid] += data.size;
@@ -56,35 +118,86 @@ void ProceedProcessor::Process(DataPiece data, Count qid) {
 
   //Check if finished
   if (sizes_[qid] == 0) {
+    //The master hears of a rebuilt range only once it is on the disk
+    if (data.tar_id == id_ && durability_ == kTaskDurability) Flush_();
     std::unique_lock<std::mutex> lck(mtxs_[0]);
     task_threads_.erase(data.task_id);
     if (data.tar_id == id_) {
-      ac_.Send(0, sizeof(data.task_id), &(data.task_id));
+      places_.erase(data.task_id);
+      ac_.SendCount(0, data.task_id);
     }
     free_threads_.push(qid);
   }
 }
 
+//Opened once, pieces are then written at their offsets side by side
+ChunkStore<FileWriter>& ProceedProcessor::Chunks_() {
+  std::call_once(store_flag_, [&] { store_.Open(path_, direct_); });
+  return store_;
+}
+
+//The first piece of a task allocates its range, only the task's thread
+//  touches its place. A task not expected is stored in chunk 0
 void ProceedProcessor::Store_(DataPiece &data) {
-  std::unique_lock<std::mutex> lck(mtxs_[id_]);
-  if (!writer_.is_open()) writer_.Open(path_);
-  writer_.Write(data.offset, data.size, data.buf);
+  std::unique_lock<std::mutex> lck(mtxs_[0]);
+  auto it = places_.find(data.task_id);
+  bool expected = (it != places_.end());
+  Place place{0, 0, 0, nullptr, 0};
+  if (expected) place = it->second;
+  lck.unlock();
+
+  if (expected && !place.file) {
+    auto at = place.offset;
+    place.file = &Chunks_().Get(place.chunk, at, place.size);
+    place.file->Preallocate(at, place.size);
+    place.shift = at - place.offset;
+    lck.lock();
+    places_[data.task_id] = place;
+    lck.unlock();
+  }
+
+  auto offset = data.offset;
+  if (place.file)
+    offset += place.shift;
+  else
+    place.file = &Chunks_().Get(0, offset, data.size);
+  place.file->Write(offset, data.size, data.buf);
+  dirty_ = true;
 }
 
-void ProceedProcessor::Send_(DataPiece &data) {
-  auto ts = std::chrono::system_clock::now();
+//Every flush is timed, what it costs is the price of durability
+void ProceedProcessor::Flush_() {
+  struct timeval start, end;
+  gettimeofday(&start, nullptr);
+  dirty_ = false;
+  Chunks_().ForEach([](FileWriter &file) { file.Sync(); });
+  gettimeofday(&end, nullptr);
 
+  Time ms = (end.tv_sec - start.tv_sec) * 1e3 +
+            (end.tv_usec - start.tv_usec) / 1e3;
+  std::unique_lock<std::mutex> lck(flush_mtx_);
+  ++flushes_.num;
+  flushes_.total += ms;
+  if (ms > flushes_.max) flushes_.max = ms;
+}
+
+//A piece's delay time is how long it takes at the flow's bandwidth. Its
+//  buffer is released once sent, which may be after the engine queued it
+void ProceedProcessor::Send_(DataPiece &data, const Count &qid) {
   //Send data
-  std::unique_lock<std::mutex> lck(mtxs_[data.tar_id]);
-  ac_.Send(data.tar_id, sizeof(data.task_id), &(data.task_id));
-  ac_.Send(data.tar_id, sizeof(data.offset), &(data.offset));
-  ac_.Send(data.tar_id, sizeof(data.size), &(data.size));
-  ac_.Send(data.tar_id, data.size, data.buf);
-  lck.unlock();
+  EventEngine::Sent sent;
+  if (releaser_) {
+    auto *buf = data.buf;
+    auto size = data.size;
+    sent = [this, buf, size] { releaser_(buf, size); };
+  }
+  ac_.SendPiece(data.tar_id, {data.task_id, data.offset, data.size},
+                data.buf, std::move(sent));
 
   if (data.delay_time > 0) {
-    auto tp = ts + std::chrono::microseconds(data.delay_time);
-    std::this_thread::sleep_until(tp);
+    pacers_[qid].SetRate(static_cast<BwType>(data.size * 8000.0 /
+                                             data.delay_time));
+    pacers_[qid].Consume(data.size);
   }
 }
 
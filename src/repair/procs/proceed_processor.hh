@@ -1,19 +1,38 @@
 #ifndef EXR_REPAIR_PROCS_PROCEEDPROCESSOR_HH_
 #define EXR_REPAIR_PROCS_PROCEEDPROCESSOR_HH_
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <queue>
 
 #include "data/access/access_center.hh"
+#include "data/file/chunk_store.hh"
 #include "data/file/file_writer.hh"
 #include "repair/procs/data_processor.hh"
+#include "util/io_ring.hh"
+#include "util/token_bucket.hh"
 #include "util/typedef.hh"
 #include "util/types.hh"
 
 namespace exr {
 
+//When the stored pieces are flushed to the disk
+const Name kNoDurability = "none";           //Left to the system
+const Name kPeriodicDurability = "periodic"; //By a thread every interval
+const Name kTaskDurability = "task";         //Before a task is acked
+
+//Flushes done: how many, their milliseconds in all and the longest
+struct FlushStats {
+  DataSize num;
+  Time total;
+  Time max;
+};
+
 /* A Processor that receive DataPieces and send them out */
 class ProceedProcessor : public DataProcessor<DataPiece>
 {
@@ -22,6 +41,25 @@ class ProceedProcessor : public DataProcessor<DataPiece>
                    const Path &path, AccessCenter &ac);
   ~ProceedProcessor();
 
+  //Store the repaired data through io_uring, a ring with the pool pinned
+  void UseRing(IORing *ring);
+  //Aligned pieces are stored bypassing the page cache, set before Run
+  void UseDirectIO();
+  //Start writing back every stored piece at once, set before Run
+  void UseWriteback();
+  //A task whose rebuilt range this node stores. The range is found in its
+  //  chunk and its blocks are allocated by the task's thread, when its
+  //  first piece comes
+  void Expect(const RepairTask &rt);
+  //Durability of the stored pieces, interval_ms for the periodic one,
+  //  set before Run
+  void SetDurability(const Name &mode, const Time &interval_ms);
+  FlushStats flush_stats();
+
+  //Called with every buffer done with: stored, or sent before returning
+  using Releaser = std::function<void(BufUnit *buf, const DataSize &size)>;
+  void SetReleaser(Releaser releaser);
+
   //ProceedProcessor is neither copyable nor movable
   ProceedProcessor(const ProceedProcessor&) = delete;
   ProceedProcessor& operator=(const ProceedProcessor&) = delete;
@@ -34,16 +72,44 @@ class ProceedProcessor : public DataProcessor<DataPiece>
   Count id_;
   AccessCenter &ac_;
   Path path_;
-  FileWriter writer_;
+  ChunkStore<FileWriter> store_;
+  std::once_flag store_flag_;
+  bool direct_;
+  bool writeback_;
+
+  //Where the pieces of every task stored here go: its range, then the
+  //  file of its chunk and how far the chunk is into it, once allocated
+  struct Place {
+    ChunkId chunk;
+    DataSize offset;
+    DataSize size;
+    FileWriter *file;
+    DataSize shift;
+  };
+  std::unordered_map<Count, Place> places_;
+
+  Name durability_;
+  Time interval_ms_;
+  std::atomic<bool> dirty_; //Stored since the last flush
+  FlushStats flushes_;
+  std::mutex flush_mtx_;
+  bool on_flush_;
+  std::condition_variable flush_cv_;
+  std::thread flusher_;
+  IORing *ring_;
+  Releaser releaser_;
 
   std::unordered_map<Count, Count> task_threads_;
   std::queue<Count> free_threads_;
   std::unique_ptr<std::mutex[]> mtxs_;
 
   std::unique_ptr<DataSize[]> sizes_;
+  std::unique_ptr<TokenBucket[]> pacers_; //Flow pacing of each queue
 
+  ChunkStore<FileWriter>& Chunks_();
+  void Flush_();
   void Store_(DataPiece &data);
-  void Send_(DataPiece &data);
+  void Send_(DataPiece &data, const Count &qid);
 };
 
 } // namespace exr
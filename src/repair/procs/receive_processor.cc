@@ -1,33 +1,73 @@
 #include "repair/procs/receive_processor.hh"
 
+#include <algorithm>
 #include <sys/time.h>
 
-#include "data/file/file_reader.hh"
+#include "data/file/prefetcher.hh"
 #include "util/rs_computer.hh"
+#include "util/token_bucket.hh"
 
 namespace exr {
 
+//Depth of a loading ring, holds all the pieces read ahead at a time
+const Count kDiskRingDepth = 32;
+
 //Constructor and destructor
 ReceiveProcessor::ReceiveProcessor(const Count &total, const Count &id,
                                    const Path &path, const Count &thr_n,
                                    AccessCenter &ac, MemoryPool &mp,
                                    DataProcessor<DataPiece> &next_prc)
     : DataProcessor<ReceiveTask>(1, thr_n),
-      id_(id), path_(path), ac_(ac), mp_(mp), next_prc_(next_prc),
-      remains_(std::make_unique<DataSize[]>(total - 1)) {
+      total_(total), id_(id), path_(path), ac_(ac), mp_(mp), next_prc_(next_prc),
+      remains_(std::make_unique<DataSize[]>(total - 1)), thr_n_(thr_n),
+      direct_(false) {
   for (Count i = 0; i < total - 1; ++i)
     remains_[i] = 0;
 }
 
 ReceiveProcessor::~ReceiveProcessor() { Close(); }
 
+//Incoming pieces are placed and forwarded by the engine's reactor
+void ReceiveProcessor::ListenAll() {
+  ac_.StartEngine(
+      [&](const Count &src_id, const PieceHeader &ph) {
+        auto *buf = mp_.Get(ph.task_id, src_id, ph.offset);
+        mp_.Place(buf, ph.size);
+        return buf;
+      },
+      [&](const Count &src_id, const PieceHeader &ph, BufUnit *buf) {
+        next_prc_.PushData({ph.task_id, ph.offset, ph.size, buf, 0, 0, 0,
+                            src_id});
+      });
+}
+
+//Fixed reads need the row registered on every ring
+void ReceiveProcessor::UseRing(IORing &owner, const iovec &row) {
+  rings_ = std::make_unique<std::unique_ptr<IORing>[]>(thr_n_);
+  for (Count i = 0; i < thr_n_; ++i) {
+    rings_[i] = std::make_unique<IORing>(kDiskRingDepth);
+    if (!rings_[i]->ShareBuffers(owner)) rings_[i]->RegisterBuffers(1, &row);
+    free_rings_.Push(rings_[i].get());
+  }
+}
+
+void ReceiveProcessor::UseDirectIO() { direct_ = true; }
+
+//The file of a task's chunk, offset is moved into it
+FileReader& ReceiveProcessor::File_(const RepairTask &rt, DataSize &offset) {
+  std::call_once(store_flag_, [&] { store_.Open(path_, direct_); });
+  return store_.Get(rt.chunk, offset, rt.size);
+}
+
 //Distribute
 Count ReceiveProcessor::Distribute(const ReceiveTask &data) { return 0; }
 
 //Distinguish between a local task and a remote task
 void ReceiveProcessor::Process(ReceiveTask data, Count qid) {
   //Send the infomation of the task to the next processor
-  if (data.src_id == id_)
+  if (data.src_id == id_ && !data.more.empty())
+    LoadMany_(std::move(data));
+  else if (data.src_id == id_)
     LoadData_(std::move(data));
   else
     ReceiveData_(std::move(data));
@@ -35,33 +75,37 @@ void ReceiveProcessor::Process(ReceiveTask data, Count qid) {
 
 //Load data from local
 void ReceiveProcessor::LoadData_(ReceiveTask data) {
+  if (SendFile_(data)) return;
+
   //Send task's size to the next processor
-  auto t = std::chrono::system_clock::now();
   next_prc_.PushData({data.rt.task_id, 0, data.rt.size, nullptr, 0, 0, 0});
 
   //Initialization
-  RSComputer rc(1, 1);
-  exr::FileReader reader;
-  BufUnit *buf = nullptr, *temp_buf = nullptr;
-  DataSize remain = data.rt.size, offset = data.rt.offset, size = 0;
+  IORing *ring = nullptr;
+  BufUnit *buf = nullptr;
+  std::unique_ptr<Prefetcher> pf;
+  DataSize remain = data.rt.size, offset = data.rt.offset,
+           size = data.rt.piece_size, done = 0;
 
-  //Check if need to load data
+  //Check if need to load data, the multiply is left to ComputeProcessor
   if (data.rt.tar_id != id_) {
-    rc.InitForEncode(&(data.rt.coef));
-    reader.Open(path_);
-    reader.SetOffset(offset);
-    buf = mp_.Get(id_, offset);
-    temp_buf = mp_.Get(data.rt.tar_id, offset);
+    if (rings_) ring = free_rings_.Pop();
+    buf = mp_.Get(data.rt.task_id, id_, offset);
+    mp_.Place(buf, remain);
+    //Pieces are read ahead while the ones before are paced out
+    auto at = offset;
+    auto &file = File_(data.rt, at);
+    pf = std::make_unique<Prefetcher>(file, ring, at, remain, size, buf);
   }
 
+  TokenBucket pacer(data.rt.bandwidth);
   TTime dt = 0;
-  size = data.rt.piece_size;
   if (data.rt.bandwidth > 0)
     dt = static_cast<TTime>((size * 8000.0) / data.rt.bandwidth);
   //Load pieces
   while (remain > 0) {
     DataPiece dp{data.rt.task_id, offset, 0, buf, data.rt.tar_id,
-                 data.rt.src_num, dt};
+                 data.rt.src_num, dt, 0, data.rt.coef};
     if (remain < size) {
       size = remain;
       if (data.rt.bandwidth > 0)
@@ -70,30 +114,120 @@ void ReceiveProcessor::LoadData_(ReceiveTask data) {
 
     if (buf) {
       dp.size = size;
-      //Load data
-      auto s = reader.Read(size, temp_buf);
-      if (s != size) {
-        std::cerr << "File is not big enough for reading..." << std::endl;
-        exit(-1);
-      }
-      //Multiply
-      BufUnit *srcs[1] = {temp_buf}, *tars[1] = {dp.buf};
-      rc.Encode(size, srcs, tars);
+      done += size;
+      pf->Wait(done);
       buf += size;
-      temp_buf += size;
-      //Wait
-      t += std::chrono::microseconds(dt);
-      std::this_thread::sleep_until(t);
+      //Keep to the task's bandwidth
+      pacer.Consume(size);
     }
 
     next_prc_.PushData(std::move(dp));
+    if (pf) pf->Use(done);
     remain -= size;
     offset += size;
   }
+  pf.reset();
+  if (ring) free_rings_.Push(ring);
+}
+
+//Tasks repairing different blocks from the same local data: every piece is
+//  read once and multiplied by all their coefficients in one call, each
+//  product going down the pipeline of its own task
+void ReceiveProcessor::LoadMany_(ReceiveTask data) {
+  std::vector<RepairTask> tasks{data.rt};
+  tasks.insert(tasks.end(), data.more.begin(), data.more.end());
+  Count num = tasks.size();
+  //Not enough spare rows for the products, load for each task alone
+  if (mp_.num() < mp_.spare() + num) {
+    for (auto &rt : tasks) LoadData_({rt, id_});
+    return;
+  }
+
+  //Send tasks' sizes to the next processor
+  BwType bw = 0;
+  std::vector<RSUnit> coefs;
+  for (auto &rt : tasks) {
+    next_prc_.PushData({rt.task_id, 0, rt.size, nullptr, 0, 0, 0});
+    coefs.push_back(rt.coef);
+    //The flows move together, so keep to the slowest of them
+    if (rt.bandwidth > 0 && (bw == 0 || rt.bandwidth < bw))
+      bw = rt.bandwidth;
+  }
+
+  //Initialization
+  IORing *ring = nullptr;
+  DataSize remain = data.rt.size, offset = data.rt.offset,
+           size = data.rt.piece_size, done = 0;
+  if (rings_) ring = free_rings_.Pop();
+  auto *buf = mp_.Get(data.rt.task_id, id_, offset);
+  mp_.Place(buf, remain);
+  auto at = offset;
+  auto &file = File_(data.rt, at);
+  auto pf = std::make_unique<Prefetcher>(file, ring, at, remain, size, buf);
+
+  TokenBucket pacer(bw);
+  std::vector<BufUnit*> outs(num);
+  while (remain > 0) {
+    if (remain < size) size = remain;
+    done += size;
+    pf->Wait(done);
+    for (Count i = 0; i < num; ++i) {
+      outs[i] = mp_.Get(mp_.spare() + i, offset);
+      mp_.Place(outs[i], size);
+    }
+    RSComputer::MultiplyMany(size, num, coefs.data(), buf, outs.data());
+    mp_.Release(buf, size);
+
+    for (Count i = 0; i < num; ++i) {
+      auto &rt = tasks[i];
+      TTime dt = 0;
+      if (rt.bandwidth > 0)
+        dt = static_cast<TTime>((size * 8000.0) / rt.bandwidth);
+      next_prc_.PushData({rt.task_id, offset, size, outs[i], rt.tar_id,
+                          rt.src_num, dt});
+    }
+    pf->Use(done);
+    pacer.Consume(size);
+    buf += size;
+    remain -= size;
+    offset += size;
+  }
+  pf.reset();
+  if (ring) free_rings_.Push(ring);
+}
+
+//A helper with no other sources and a coefficient of one forwards its data
+//  as it is: the file's ranges go to the target by sendfile, skipping the
+//  pool, the multiply and the processors behind this one
+bool ReceiveProcessor::SendFile_(const ReceiveTask &data) {
+  auto &rt = data.rt;
+  if (rt.tar_id == id_ || rt.coef != 1 || rt.src_num != 1 ||
+      !ac_.can_send_file(rt.tar_id))
+    return false;
+
+  auto at = rt.offset;
+  auto &file = File_(rt, at);
+  if (file.file_size() < at + rt.size) {
+    std::cerr << "File is not big enough for reading..." << std::endl;
+    exit(-1);
+  }
+
+  //Keep to the task's bandwidth
+  TokenBucket pacer(rt.bandwidth);
+  for (DataSize done = 0; done < rt.size; done += rt.piece_size) {
+    auto size = std::min(rt.size - done, rt.piece_size);
+    ac_.SendFilePiece(rt.tar_id, {rt.task_id, rt.offset + done, size},
+                      file.handle(), at + done);
+    pacer.Consume(size);
+  }
+  return true;
 }
 
 //Get pieces from other nodes
 void ReceiveProcessor::ReceiveData_(ReceiveTask data) {
+  //Nothing to wait for, the engine delivers the pieces by itself
+  if (ac_.is_event_driven(data.src_id)) return;
+
   std::unique_lock<std::mutex> lck(mtx_);
   remains_[data.src_id - 1] += data.rt.size;
   //If a task of the same source is running, this thread needn't do anything
@@ -103,12 +237,14 @@ void ReceiveProcessor::ReceiveData_(ReceiveTask data) {
   while (remains_[data.src_id - 1] > 0) {
     lck.unlock();
 
-    DataPiece dp{0, 0, 0, nullptr, 0, 0, 0};
-    ac_.Receive(data.src_id, sizeof(dp.task_id), &(dp.task_id));
-    ac_.Receive(data.src_id, sizeof(dp.offset), &(dp.offset));
-    ac_.Receive(data.src_id, sizeof(dp.size), &(dp.size));
-    dp.buf = mp_.Get(data.src_id, dp.offset);
-    ac_.Receive(data.src_id, dp.size, dp.buf);
+    //Header first, then the payload straight into its place
+    PieceHeader ph;
+    auto *buf = ac_.ReceivePiece(data.src_id, ph, [&](const PieceHeader &h) {
+      auto *at = mp_.Get(h.task_id, data.src_id, h.offset);
+      mp_.Place(at, h.size);
+      return at;
+    });
+    DataPiece dp{ph.task_id, ph.offset, ph.size, buf, 0, 0, 0, data.src_id};
 
     auto size = dp.size;
     next_prc_.PushData(std::move(dp));
@@ -5,14 +5,19 @@
 #include <mutex>
 
 #include "data/access/access_center.hh"
+#include "data/file/chunk_store.hh"
+#include "data/file/file_reader.hh"
 #include "repair/procs/data_processor.hh"
+#include "util/io_ring.hh"
 #include "util/memory_pool.hh"
 #include "util/typedef.hh"
 #include "util/types.hh"
 
 namespace exr {
 
-/* A Processor that can load local data and receive data from other nodes */
+/* A Processor that can load local data and receive data from other nodes.
+   Rows of the pool after the nodes' ones hold the products of a load
+   shared by several tasks */
 class ReceiveProcessor : public DataProcessor<ReceiveTask>
 {
  public:
@@ -22,6 +27,16 @@ class ReceiveProcessor : public DataProcessor<ReceiveTask>
                    DataProcessor<DataPiece> &next_prc);
   ~ReceiveProcessor();
 
+  //Let AccessCenter's event engine deliver the pieces of other nodes
+  void ListenAll();
+
+  //Load local data through io_uring, one ring per loading thread, with
+  //  the buffers pinned by owner. Loads land in row, this node's one,
+  //  which is pinned alone if owner's buffers can't be shared
+  void UseRing(IORing &owner, const iovec &row);
+  //Aligned loads bypass the page cache, set before Run
+  void UseDirectIO();
+
   //ReceiveProcessor is neither copyable nor movable
   ReceiveProcessor(const ReceiveProcessor&) = delete;
   ReceiveProcessor& operator=(const ReceiveProcessor&) = delete;
@@ -31,6 +46,7 @@ class ReceiveProcessor : public DataProcessor<ReceiveTask>
   void Process(ReceiveTask data, Count qid) override;
 
  private:
+  Count total_;
   Count id_;
   Path path_;
   AccessCenter &ac_;
@@ -41,7 +57,21 @@ class ReceiveProcessor : public DataProcessor<ReceiveTask>
   std::unique_ptr<DataSize[]> remains_;
   std::mutex mtx_;
 
+  //Rings for local loading, taken by a thread for a whole task
+  Count thr_n_;
+  std::unique_ptr<std::unique_ptr<IORing>[]> rings_;
+  WaitingQueue<IORing*> free_rings_;
+
+  //Local chunks, every file opened once and shared by the loads and the
+  //  ranges sent without a copy
+  ChunkStore<FileReader> store_;
+  std::once_flag store_flag_;
+  bool direct_;
+  FileReader& File_(const RepairTask &rt, DataSize &offset);
+
   void LoadData_(ReceiveTask data);
+  void LoadMany_(ReceiveTask data);
+  bool SendFile_(const ReceiveTask &data);
   void ReceiveData_(ReceiveTask data);
 };
 
@@ -7,6 +7,7 @@
 #include "repair/procs/proceed_processor.hh"
 #include "util/memory_pool.hh"
 #include "util/typedef.hh"
+#include "util/types.hh"
 
 int main()
 {
@@ -46,8 +47,7 @@ int main()
   bandwidth = 250000;
   std::cout << std::endl << "Single send task test started" << std::endl;
   t[0] = std::thread([&] {
-    exr::Count task_id;
-    ac[0].Receive(2, sizeof(task_id), &task_id);
+    auto task_id = ac[0].ReceiveCount(2);
     gettimeofday(&end_time, nullptr);
     double duration = (end_time.tv_sec - start_time.tv_sec) * 1e6 +
                       (end_time.tv_usec - start_time.tv_usec);
@@ -58,17 +58,14 @@ int main()
               << std::endl;
   });
   t[1] = std::thread([&] {
-    exr::Count tt;
-    exr::DataSize nn = 0, oo, ss;
+    exr::PieceHeader ph;
+    exr::DataSize nn = 0;
     exr::BufUnit bb[buf_size];
     while (nn < size) {
-      ac[2].Receive(id, sizeof(tt), &tt);
-      ac[2].Receive(id, sizeof(oo), &oo);
-      ac[2].Receive(id, sizeof(ss), &ss);
-      ac[2].Receive(id, ss, bb);
-      nn += ss;
+      ac[2].ReceivePiece(id, ph, [&](const exr::PieceHeader&) { return bb; });
+      nn += ph.size;
     }
-    ac[2].Send(0, sizeof(tt), &tt);
+    ac[2].SendCount(0, ph.task_id);
   });
   pp.PushData({5, 0, size, nullptr, 0, 0, 0});
   gettimeofday(&start_time, nullptr);
@@ -87,8 +84,7 @@ int main()
   bandwidth = 250000;
   std::cout << std::endl << "Single store task test started" << std::endl;
   t[0] = std::thread([&] {
-    exr::Count task_id;
-    ac[0].Receive(id, sizeof(task_id), &task_id);
+    auto task_id = ac[0].ReceiveCount(id);
     gettimeofday(&end_time, nullptr);
     double duration = (end_time.tv_sec - start_time.tv_sec) * 1e6 +
                       (end_time.tv_usec - start_time.tv_usec);
@@ -117,8 +113,7 @@ int main()
   std::mutex mtx;
   for (exr::Count i = 0; i < 2; ++i) {
     tint[i] = std::thread([&, i] {
-      exr::Count ftid, eid = i + 2;
-      ac[0].Receive(eid, sizeof(ftid), &ftid);
+      auto ftid = ac[0].ReceiveCount(i + 2);
       struct timeval etime;
       gettimeofday(&etime, nullptr);
       double duration = (etime.tv_sec - start_time.tv_sec) * 1e6 +
@@ -133,17 +128,15 @@ int main()
   }
   for (int i = 0; i < 2; ++i) {
     trec[i] = std::thread([&, i] {
-      exr::Count tt;
-      exr::DataSize oo, ss, nn = 0;
+      exr::PieceHeader ph;
+      exr::DataSize nn = 0;
       exr::BufUnit bb[buf_size];
       while (nn < size) {
-        ac[i + 2].Receive(id, sizeof(tt), &tt);
-        ac[i + 2].Receive(id, sizeof(oo), &oo);
-        ac[i + 2].Receive(id, sizeof(ss), &ss);
-        ac[i + 2].Receive(id, ss, bb);
-        nn += ss;
+        ac[i + 2].ReceivePiece(id, ph,
+                               [&](const exr::PieceHeader&) { return bb; });
+        nn += ph.size;
       }
-      ac[i + 2].Send(0, sizeof(tt), &tt);
+      ac[i + 2].SendCount(0, ph.task_id);
     });
   }
   gettimeofday(&start_time, nullptr);
@@ -87,10 +87,7 @@ int main()
   exr::Count task_id = 2;
   exr::DataSize offset = 80, size = 5;
   exr::BufUnit temp_buf[20] = "abcdefghijk";
-  ac[2].Send(id, sizeof(task_id), &task_id);
-  ac[2].Send(id, sizeof(offset), &offset);
-  ac[2].Send(id, sizeof(size), &size);
-  ac[2].Send(id, size, temp_buf);
+  ac[2].SendPiece(id, {task_id, offset, size}, temp_buf);
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
   std::cout << "Pushing a task" << std::endl;
@@ -101,18 +98,12 @@ int main()
   exr::Count task_id2 = 3;
   exr::DataSize offset2 = 256, size2 = 10;
   exr::BufUnit temp_buf2[20] = "ABCDEFGHIJK";
-  ac[2].Send(id, sizeof(task_id2), &task_id2);
-  ac[2].Send(id, sizeof(offset2), &offset2);
-  ac[2].Send(id, sizeof(size2), &size2);
-  ac[2].Send(id, size2, temp_buf2);
+  ac[2].SendPiece(id, {task_id2, offset2, size2}, temp_buf2);
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
   std::cout << "Sending a piece" << std::endl;
   offset += size;
-  ac[2].Send(id, sizeof(task_id), &task_id);
-  ac[2].Send(id, sizeof(offset), &offset);
-  ac[2].Send(id, sizeof(size), &size);
-  ac[2].Send(id, size, temp_buf + size);
+  ac[2].SendPiece(id, {task_id, offset, size}, temp_buf + size);
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
   std::cout << "Pushing a task" << std::endl;
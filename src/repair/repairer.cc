@@ -1,20 +1,46 @@
 #include "repair/repairer.hh"
 
+#include <algorithm>
+#include <vector>
+
+#include "util/io_ring.hh"
+#include "util/wire.hh"
+
 namespace exr {
 
+//Depth of the storing ring, pieces are written one at a time
+const Count kStoreRingDepth = 4;
+
+//Bytes of a plan read at a time
+const DataSize kPlanChunk = 4096;
+
 //Constructor
 Repairer::Repairer(const Count &id, const Count &total,
                    const Path &load_path, const Path &store_path,
                    const Count &block_num, const DataSize &size,
                    const Path &bandwidth_path, const Name &eth_name,
                    const bool &if_print, const Count &recv_thr_num,
-                   const Count &comp_thr_num, const Count &proc_thr_num)
-    : id_(id), ac_(id, total), mp_(block_num, size),
+                   const Count &comp_thr_num, const Count &proc_thr_num,
+                   const Name &transport, const Count &link_num,
+                   const bool &direct_io, const bool &writeback,
+                   const Name &durability, const Time &flush_ms,
+                   const bool &shm_lend)
+    : id_(id), ac_(id, total, link_num), mp_(block_num, size, total),
       proceeder_(id, total, proc_thr_num, store_path, ac_),
       computer_(comp_thr_num, mp_, proceeder_),
       receiver_(total, id, load_path, recv_thr_num, ac_, mp_, computer_),
-      bs_(eth_name, if_print), bandwidth_path_(bandwidth_path),
-      on_run_(false) {}
+      bs_(eth_name, if_print,
+          [&](const Bandwidth &bw) { ac_.SetBandwidth(bw); }),
+      bandwidth_path_(bandwidth_path),
+      transport_(transport), on_run_(false) {
+  if (direct_io) {
+    receiver_.UseDirectIO();
+    proceeder_.UseDirectIO();
+  }
+  if (writeback) proceeder_.UseWriteback();
+  proceeder_.SetDurability(durability, flush_ms);
+  if (shm_lend) ac_.LendLocal();
+}
 
 //Destructor: to be sure that all the threads is already closed
 Repairer::~Repairer() { WaitForFinish(); }
@@ -22,6 +48,16 @@ Repairer::~Repairer() { WaitForFinish(); }
 //Connect to other nodes and start the threads
 void Repairer::Prepare(const IPAddressList &ip_addresses) {
   ac_.Connect(ip_addresses);
+  proceeder_.SetReleaser([&](BufUnit *buf, const DataSize &size) {
+    mp_.Release(buf, size);
+  });
+  if (transport_ == kEventTransport) {
+    computer_.SetReleaser([&](const Count &src) { ac_.ReleasePiece(src); });
+    receiver_.ListenAll();
+  }
+  if (transport_ == kUringTransport) UseRing_();
+  //Tasks are sharded over the compute queues, spread them over the nodes
+  computer_.SpreadOverNodes();
   receiver_.Run();
   computer_.Run();
   proceeder_.Run();
@@ -31,11 +67,34 @@ void Repairer::Prepare(const IPAddressList &ip_addresses) {
   on_run_ = true;
 }
 
+//Sockets and files go through io_uring, otherwise stay blocking
+void Repairer::UseRing_() {
+  if (!IORing::Supported()) {
+    std::cerr << "io_uring unavailable, using the block transport"
+              << std::endl;
+    return;
+  }
+  mp_.Pin();
+  std::vector<iovec> iov(mp_.num());
+  for (Count i = 0; i < mp_.num(); ++i)
+    iov[i] = {mp_.Get(i, 0), static_cast<size_t>(mp_.size())};
+  ring_ = std::make_unique<IORing>(kStoreRingDepth);
+  ring_->RegisterBuffers(iov.size(), iov.data());
+  ac_.UseRing(*ring_, iov.data());
+  receiver_.UseRing(*ring_, iov[id_]);
+  proceeder_.UseRing(ring_.get());
+}
+
+Time Repairer::connect_time() { return ac_.connect_time(); }
+
+FlushStats Repairer::flush_stats() { return proceeder_.flush_stats(); }
+
 //Used by creator to wait for this repairer closed by the master node
 void Repairer::WaitForFinish() {
   std::unique_lock<std::mutex> lck(mtx_);
   if (on_run_) {
     task_getter_.join();
+    ac_.StopEngine();
     on_run_ = false;
   }
 }
@@ -43,14 +102,17 @@ void Repairer::WaitForFinish() {
 //Get tasks from the master
 void Repairer::GetTaks() {
   RepairTask rt;
-  Count src_id;
   while (true) {
     //Get from master and check if can quit
-    ac_.Receive(0, sizeof(rt), &rt);
+    ac_.ReceiveTask(0, rt);
     if (rt.size == 0) {
       if (rt.piece_size == 0) {
         //No more task, the repair is ended
         break;
+      } else if (rt.piece_size == kPlanMessage) {
+        //A group of tasks
+        ReceivePlan_(rt);
+        continue;
       } else {
         //Bandwidth
         if (rt.offset > 0) {
@@ -65,21 +127,68 @@ void Repairer::GetTaks() {
           bs_.SetBandwidth(id_, rt.bandwidth == 0);
         }
         //Tell the master that is already finished
-        ac_.Send(0, sizeof(src_id), &src_id);
+        ac_.SendCount(0, id_);
         continue;
       }
     }
 
-    //Has a new task, deliver to the processors
-    rt.src_num += 1;
-    receiver_.PushData({rt, id_});
-    for (Count i = 1; i < rt.src_num; ++i) {
-      ac_.Receive(0, sizeof(src_id), &src_id);
-      receiver_.PushData({rt, src_id});
-    }
     //if (rt.tar_id == id_) rt.piece_size = 0 - rt.piece_size;
     //receiver_.PushData({rt, id_});
   }
 }
 
+//Decode the plan while it is still coming, every task is delivered to the
+//  processors as soon as it is complete. Loads of local data wait for the
+//  end of the plan, so tasks reading the same range share one load
+void Repairer::ReceivePlan_(const RepairTask &head) {
+  std::vector<BufUnit> plan(head.offset);
+  std::vector<ReceiveTask> loads;
+  DataSize got = 0, pos = 0;
+  while (got < head.offset) {
+    auto len = std::min(head.offset - got, kPlanChunk);
+    ac_.Receive(0, len, plan.data() + got);
+    got += len;
+
+    //Every task is followed by its varint-packed sources
+    WireReader reader(plan.data() + pos, got - pos, ac_.wire_version(0));
+    RepairTask rt;
+    std::vector<Count> srcs;
+    DataSize done = 0;
+    while (reader.GetTask(rt)) {
+      srcs.resize(rt.src_num);
+      Count i = 0;
+      for (uint64_t v; i < rt.src_num && reader.GetVarint(v); ++i) srcs[i] = v;
+      if (i < rt.src_num) break;
+
+      //Has a new task, deliver to the processors
+      rt.src_num += 1;
+      if (rt.tar_id == id_) {
+        //This node stores the task's range
+        proceeder_.Expect(rt);
+        receiver_.PushData({rt, id_});
+      } else {
+        AddLoad_(loads, rt);
+      }
+      for (auto &src_id : srcs) receiver_.PushData({rt, src_id});
+      done = reader.pos();
+    }
+    pos += done;
+  }
+  for (auto &load : loads) receiver_.PushData(std::move(load));
+}
+
+void Repairer::AddLoad_(std::vector<ReceiveTask> &loads,
+                        const RepairTask &rt) {
+  auto same = std::find_if(loads.begin(), loads.end(),
+                           [&](const ReceiveTask &load) {
+    return load.rt.chunk == rt.chunk && load.rt.offset == rt.offset &&
+           load.rt.size == rt.size &&
+           load.rt.piece_size == rt.piece_size;
+  });
+  if (same == loads.end())
+    loads.push_back({rt, id_});
+  else
+    same->more.push_back(rt);
+}
+
 } // namespace exprocessors
@@ -4,12 +4,14 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "config/bandwidth_solver.hh"
 #include "data/access/access_center.hh"
 #include "repair/procs/compute_processor.hh"
 #include "repair/procs/receive_processor.hh"
 #include "repair/procs/proceed_processor.hh"
+#include "util/io_ring.hh"
 #include "util/memory_pool.hh"
 #include "util/typedef.hh"
 #include "util/types.hh"
@@ -25,13 +27,21 @@ class Repairer
            const Count &block_num, const DataSize &size,
            const Path &bandwidth_path, const Name &eth_name,
            const bool &if_print, const Count &recv_thr_num,
-           const Count &comp_thr_num, const Count &proc_thr_num);
+           const Count &comp_thr_num, const Count &proc_thr_num,
+           const Name &transport, const Count &link_num,
+           const bool &direct_io = false, const bool &writeback = false,
+           const Name &durability = kNoDurability,
+           const Time &flush_ms = 0, const bool &shm_lend = false);
   ~Repairer();
 
   //Connect to other nodes and prepare for repairing
   void Prepare(const IPAddressList &ip_addresses);
   //Wait Master to send close signal and wait for the repairer to be closed
   void WaitForFinish();
+  //Milliseconds spent connecting to the other nodes
+  Time connect_time();
+  //Flushes of the rebuilt data and what they took
+  FlushStats flush_stats();
 
   //Repairer is neither copyable nor movable
   Repairer(const Repairer&) = delete;
@@ -39,6 +49,8 @@ class Repairer
 
  private:
   Count id_;
+  //Pins the pool once for all the rings, stores through it
+  std::unique_ptr<IORing> ring_;
   AccessCenter ac_;
   MemoryPool mp_;
   ProceedProcessor proceeder_;
@@ -47,11 +59,15 @@ class Repairer
 
   BandwidthSolver bs_;
   Path bandwidth_path_;
+  Name transport_;
 
   bool on_run_;
   std::mutex mtx_;
   std::thread task_getter_;
   void GetTaks();
+  void ReceivePlan_(const RepairTask &head);
+  void AddLoad_(std::vector<ReceiveTask> &loads, const RepairTask &rt);
+  void UseRing_();
 };
 
 } // namespace exr
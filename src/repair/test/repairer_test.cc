@@ -1,11 +1,17 @@
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include "data/access/access_center.hh"
 #include "repair/repairer.hh"
 #include "util/typedef.hh"
 #include "util/types.hh"
+#include "util/wire.hh"
 
 int main()
 {
@@ -23,25 +29,29 @@ int main()
     {"localhost", 10089} });
   exr::Path bw_path = "";
   exr::Name eth_name = "";
+  exr::Name transport = exr::kEventTransport;
+  const exr::Count link_num = 2;
 
   //Initialize
   auto _ = system(("dd if=/dev/urandom of=" + dpath + pathr +
                    " bs=2097152 count=64").c_str());
   const exr::Count total = 7;
   const exr::DataSize bsize = 67108864;
+  //Two lanes of rows, and spare rows for the products of two tasks
+  const exr::Count rows = 2 * total + 2;
   exr::Repairer nr[total - 1] = {
-    {1, total, dpath + pathr, dpath + "1" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10},
-    {2, total, dpath + pathr, dpath + "2" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10},
-    {3, total, dpath + pathr, dpath + "3" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10},
-    {4, total, dpath + pathr, dpath + "4" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10},
-    {5, total, dpath + pathr, dpath + "5" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10},
-    {6, total, dpath + pathr, dpath + "6" + pathw, total, bsize,
-     bw_path, eth_name, true, 6, 3, 10}};
+    {1, total, dpath + pathr, dpath + "1" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num},
+    {2, total, dpath + pathr, dpath + "2" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num},
+    {3, total, dpath + pathr, dpath + "3" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num},
+    {4, total, dpath + pathr, dpath + "4" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num},
+    {5, total, dpath + pathr, dpath + "5" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num},
+    {6, total, dpath + pathr, dpath + "6" + pathw, rows, bsize,
+     bw_path, eth_name, true, 6, 3, 10, transport, link_num}};
   exr::AccessCenter ac(0, total);
 
   //Connect
@@ -53,59 +63,74 @@ int main()
     t[i].join();
   std::cout << "Connected and has prepared for repairing..." << std::endl;
 
+  //A task goes to a node as a plan of its own
+  auto send_task = [&](const exr::Count &nid, const exr::RepairTask &rt,
+                       std::initializer_list<exr::Count> srcs) {
+    exr::WireWriter plan(ac.wire_version(nid));
+    plan.PutTask(rt);
+    for (auto src : srcs) plan.PutVarint(src);
+    exr::RepairTask head{1, 0, 0, plan.size(), 0, exr::kPlanMessage, 0, 0};
+    ac.SendTask(nid, head, plan.size(), plan.data());
+  };
+  //Several tasks in one plan
+  using PlanTask = std::pair<exr::RepairTask, std::vector<exr::Count>>;
+  auto send_plan = [&](const exr::Count &nid,
+                       const std::vector<PlanTask> &tasks) {
+    exr::WireWriter plan(ac.wire_version(nid));
+    for (auto &task : tasks) {
+      plan.PutTask(task.first);
+      for (auto src : task.second) plan.PutVarint(src);
+    }
+    exr::RepairTask head{static_cast<exr::Count>(tasks.size()), 0, 0,
+                         plan.size(), 0, exr::kPlanMessage, 0, 0};
+    ac.SendTask(nid, head, plan.size(), plan.data());
+  };
+
   exr::Count c1 = 1, c2 = 2, c3 = 3, c4 = 4, c5 = 5;
   exr::Count r = 0;
   exr::BwType bandwidth = 1000000;
   //Test #1 piece 100
   exr::RepairTask task{1, 0, 2, 0, 1024, 1024, 1, bandwidth};
-  ac.Send(1, sizeof(task), &task);
+  send_task(1, task, {});
 
   task.src_num = 1;
   task.tar_id = 3;
-  ac.Send(2, sizeof(task), &task);
-  ac.Send(2, sizeof(c1), &(c1));
+  send_task(2, task, {c1});
 
-  ac.Send(3, sizeof(task), &task);
-  ac.Send(3, sizeof(c2), &(c2));
+  send_task(3, task, {c2});
 
-  ac.Receive(3, sizeof(r), &r);
+  r = ac.ReceiveCount(3);
   std::cout << "node 1, 2, 3 compeleted task " << r << std::endl;
 
   //Test #2 & #3 piece 10
   std::cout << "start task2 and task3 simultaneously" << std::endl;
   exr::RepairTask task2{2, 0, 2, 0, 1024, 1024, 1, bandwidth};
-  ac.Send(1, sizeof(task2), &task2);
-  ac.Send(3, sizeof(task2), &task2);
+  send_task(1, task2, {});
+  send_task(3, task2, {});
 
   exr::RepairTask task3{3, 1, 1, 0, 1024, 1024, 1, bandwidth};
-  ac.Send(2, sizeof(task3), &task3);
-  ac.Send(2, sizeof(c3), &(c3));
+  send_task(2, task3, {c3});
 
   task3.src_num = 0;
   task3.tar_id = 2;
-  ac.Send(3, sizeof(task3), &task3);
+  send_task(3, task3, {});
 
   task2.src_num = 2;
-  ac.Send(2, sizeof(task2), &task2);
-  ac.Send(2, sizeof(c3), &(c3));
-  ac.Send(2, sizeof(c1), &(c1));
+  send_task(2, task2, {c3, c1});
 
   task3.src_num = 1;
   task3.tar_id = 1;
-  ac.Send(1, sizeof(task3), &task3);
-  ac.Send(1, sizeof(c2), &(c2));
+  send_task(1, task3, {c2});
 
   std::mutex mtx;
   t[0] = std::thread([&] {
-    exr::Count k;
-    ac.Receive(1, sizeof(k), &k);
+    auto k = ac.ReceiveCount(1);
     std::unique_lock<std::mutex> lck(mtx);
     std::cout << "node 1, 2, 3 compeleted task " << k << std::endl;
     lck.unlock();
   });
   t[1] = std::thread([&] {
-    exr::Count k;
-    ac.Receive(2, sizeof(k), &k);
+    auto k = ac.ReceiveCount(2);
     std::unique_lock<std::mutex> lck(mtx);
     std::cout << "node 1, 2, 3 compeleted task " << k << std::endl;
     lck.unlock();
@@ -117,32 +142,65 @@ int main()
   std::cout << "start task4" << std::endl;
   exr::DataSize size = 67108864, psize = 67108864 / 4;
   auto task4 = exr::RepairTask{4, 0, 3, 0, size, psize, 1, bandwidth};
-  ac.Send(2, sizeof(task4), &task4);
+  send_task(2, task4, {});
 
   task4.tar_id = 4;
   task4.src_num = 1;
-  ac.Send(3, sizeof(task4), &task4);
-  ac.Send(3, sizeof(c2), &(c2));
+  send_task(3, task4, {c2});
 
   task4.tar_id = 5;
-  ac.Send(4, sizeof(task4), &task4);
-  ac.Send(4, sizeof(c3), &(c3));
+  send_task(4, task4, {c3});
 
   task4.tar_id = 1;
-  ac.Send(5, sizeof(task4), &task4);
-  ac.Send(5, sizeof(c4), &(c4));
+  send_task(5, task4, {c4});
 
-  ac.Send(1, sizeof(task4), &task4);
-  ac.Send(1, sizeof(c5), &(c5));
+  send_task(1, task4, {c5});
 
-  ac.Receive(1, sizeof(r), &r);
+  r = ac.ReceiveCount(1);
   std::cout << "node 2, 3, 4, 5, 1 compeleted task " << r << std::endl;
 
+  //Test #5 two failures: tasks 5 and 6 rebuild the same range on nodes 4
+  //  and 5 from nodes 1, 2 and 3. Node 2 gets both tasks' pieces of node 1
+  //  at the same offsets. The coefficients of each task add up to 1, and
+  //  the nodes all keep the same data, so both targets store that data
+  std::cout << "start task5 and task6 of two failures" << std::endl;
+  size = 1048576;
+  psize = size / 4;
+  exr::Count c6 = 6;
+  auto task5 = exr::RepairTask{5, 0, 2, 0, size, psize, 1, bandwidth};
+  auto task6 = exr::RepairTask{c6, 0, 2, 0, size, psize, 2, bandwidth};
+  send_plan(1, {{task5, {}}, {task6, {}}});
+  task5.src_num = task6.src_num = 1;
+  task5.tar_id = 4;
+  task6.tar_id = 5;
+  task6.coef = 4;
+  send_plan(2, {{task5, {c1}}, {task6, {c1}}});
+  task5.src_num = task6.src_num = 0;
+  task6.coef = 7;
+  send_plan(3, {{task5, {}}, {task6, {}}});
+  task5.src_num = task6.src_num = 2;
+  send_plan(4, {{task5, {c2, c3}}});
+  send_plan(5, {{task6, {c2, c3}}});
+
+  r = ac.ReceiveCount(4);
+  std::cout << "node 1, 2, 3, 4 compeleted task " << r << std::endl;
+  r = ac.ReceiveCount(5);
+  std::cout << "node 1, 2, 3, 5 compeleted task " << r << std::endl;
+  std::vector<char> data(size), stored(size);
+  std::ifstream(dpath + pathr).read(data.data(), size);
+  for (exr::Count nid : {c4, c5}) {
+    std::ifstream(dpath + std::to_string(nid) + pathw).read(stored.data(),
+                                                            size);
+    std::cout << "node " << nid << " stored "
+              << (memcmp(data.data(), stored.data(), size) == 0 ?
+                  "the lost data" : "WRONG DATA") << std::endl;
+  }
+
   //Close
   _ = system(("rm " + dpath + "*.txt").c_str());
-  exr::RepairTask end_task{0, 0, 0, 0, 0, 0, 0};
+  exr::RepairTask end_task{0, 0, 0, 0, 0, 0, 0, 0};
   for (int i = 1; i < total; ++i) {
-    ac.Send(i, sizeof(end_task), &end_task);
+    ac.SendTask(i, end_task);
     nr[i - 1].WaitForFinish();
   }
   std::cout << "Closed, test ended" << std::endl;
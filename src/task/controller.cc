@@ -1,7 +1,11 @@
 #include "task/controller.hh"
 
+#include <algorithm>
+#include <iostream>
+#include <limits>
 #include <sys/time.h>
 #include <thread>
+#include <utility>
 
 #include "task/algorithm/best_flow.hh"
 #include "task/algorithm/eva_pipe.hh"
@@ -10,13 +14,21 @@
 #include "task/algorithm/ppr.hh"
 #include "task/task_reader.hh"
 #include "util/types.hh"
+#include "util/wire.hh"
 
 namespace exr {
 
-Controller::Controller(const Count &total,
-                       const DataSize &size, const DataSize &psize)
-    : size_(size), psize_(psize), ac_(0, total), ptg_(nullptr),
-      cur_tid_(0), gnum_(0), task_num_(0) {
+//Task ids wrap around after this many
+const DataSize kTaskIdRange =
+    static_cast<DataSize>(std::numeric_limits<Count>::max()) + 1;
+
+Controller::Controller(const Count &total, const DataSize &size,
+                       const DataSize &psize, const DataSize &window,
+                       const Count &lanes)
+    : total_(total), size_(size), psize_(psize), window_(window),
+      lanes_(lanes), ac_(0, total), ptg_(nullptr), fixed_(false),
+      cur_tid_(0), gnum_(0), stripe_(0), task_num_(0), win_offset_(0),
+      win_size_(size) {
   src_lists_ = std::make_unique<std::unique_ptr<Count[]>[]>(total - 1);
   for (Count i = 0; i < total - 1; ++i)
     src_lists_[i] = std::make_unique<Count[]>(total - 2);
@@ -28,8 +40,16 @@ void Controller::Connect(const IPAddressList &ip_addresses) {
   ac_.Connect(ip_addresses);
 }
 
+Time Controller::connect_time() { return ac_.connect_time(); }
+
+//Every algorithm line starts with the k and n of the code it repairs
 void Controller::ChangeAlg(const Alg &alg, const Count *args,
                            const Path &path) {
+  fixed_ = (alg == 't');
+  if (args)
+    dc_ = std::make_unique<DecodeCache>(args[1], args[0]);
+  else
+    dc_.reset();
   if (alg == 't') {
     ptg_ = pTaskGetter(new TaskReader(path));
   } else if (alg == 'b') {
@@ -61,18 +81,41 @@ bool Controller::GetTasks() {
 
 BwType Controller::GetCapacity() { return ptg_->get_capacity(); }
 
+//A group repairs the block window by window. The next window is sent
+//  before waiting for the one before, so the pipelines never run dry and a
+//  node's rows only hold two windows
 Count Controller::DoTaskGroups(const Count &total) {
   Count max_task_num = 0;
   auto t = std::make_unique<std::thread[]>(total - 1);
+  auto window = (window_ > 0 && !fixed_) ? window_ : size_;
   for (Count i = 0; i < gnum_; ++i) {
     task_num_ = ptg_->GetTaskNumber(i);
-    //Send tasks of one group
-    for (Count j = 1; j < total; ++j)
-      t[j-1] = std::thread([&, i, j] { DeliverTasks_(i, j); });
-    for (Count j = 0; j < total - 1; ++j) t[j].join();
+    //The ids may wrap, but the two windows in flight must not share one:
+    //  nodes and acks tell tasks apart by id alone
+    if (2 * static_cast<DataSize>(task_num_) > kTaskIdRange) {
+      std::cerr << "Group " << i << " has " << task_num_ << " tasks, two "
+                << "windows of them need more than " << kTaskIdRange
+                << " task ids" << std::endl;
+      exit(-1);
+    }
+    ComputeCoefs_(i);
+    Count last_tid = cur_tid_;
+    for (win_offset_ = 0; win_offset_ < size_; win_offset_ += window) {
+      win_size_ = std::min(window, size_ - win_offset_);
+      CheckRanges_(i);
+      //Send tasks of one window
+      for (Count j = 1; j < total; ++j)
+        t[j-1] = std::thread([&, i, j] { DeliverTasks_(i, j); });
+      for (Count j = 0; j < total - 1; ++j) t[j].join();
+      //Wait for the window before
+      if (win_offset_ > 0) WaitForFinish_(last_tid);
+      last_tid = cur_tid_;
+      cur_tid_ += task_num_;
+    }
     //Wait for finishing
     if (task_num_ > max_task_num) max_task_num = task_num_;
-    WaitForFinish_();
+    WaitForFinish_(last_tid);
+    ++stripe_;
   }
   return max_task_num;
 }
@@ -80,56 +123,153 @@ Count Controller::DoTaskGroups(const Count &total) {
 void Controller::Close(const Count &total) {
   RepairTask end_task{0, 0, 0, 0, 0, 0, 0, 0};
   for (Count i = 1; i < total; ++i)
-    ac_.Send(i, sizeof(end_task), &end_task);
+    ac_.SendTask(i, end_task);
 }
 
 void Controller::ReloadNodeBandwidth(const Count &total) {
   RepairTask reload_info{0, 0, 0, 1, 0, 1, 0, 0};
   for (Count i = 1; i < total; ++i)
-    ac_.Send(i, sizeof(reload_info), &reload_info);
-  Count r;
-  for (Count i = 1; i < total; ++i) ac_.Receive(i, sizeof(r), &r);
+    ac_.SendTask(i, reload_info);
+  for (Count i = 1; i < total; ++i) ac_.ReceiveCount(i);
 }
 
 void Controller::SetNewNodeBandwidth(const Count &total) {
   RepairTask set_new_info{0, 0, 0, 0, 0, 1, 0, 1};
   for (Count i = 1; i < total; ++i) {
     if (i == ptg_->GetRid()) set_new_info.bandwidth = 0;
-    ac_.Send(i, sizeof(set_new_info), &set_new_info);
+    ac_.SendTask(i, set_new_info);
     set_new_info.bandwidth = 1;
   }
-  Count r;
-  for (Count i = 1; i < total; ++i) ac_.Receive(i, sizeof(r), &r);
+  for (Count i = 1; i < total; ++i) ac_.ReceiveCount(i);
 }
 
+//The requester of a task is the node storing its own target, the others
+//  are its helpers. Each helper's block is multiplied by its coefficient,
+//  all of them are 1 (XOR) if the algorithm didn't give the code
+void Controller::ComputeCoefs_(const Count &gid) {
+  coefs_.assign(task_num_ * total_, 1);
+  if (!dc_) return;
+  auto srcs = std::make_unique<Count[]>(total_);
+  for (Count j = 0; j < task_num_; ++j) {
+    std::vector<Count> helpers, blocks;
+    Count failed = 0;
+    for (Count nid = 1; nid < total_; ++nid) {
+      RepairTask rt{static_cast<Count>(cur_tid_ + j), 0, 0, win_offset_,
+                    win_size_, psize_, 1, 0, stripe_};
+      ptg_->FillTask(gid, j, nid, rt, srcs.get());
+      if (rt.size == 0) continue;
+      if (rt.tar_id == nid) {
+        failed = nid;
+      } else {
+        helpers.push_back(nid);
+        blocks.push_back(nid - 1);
+      }
+    }
+    if (failed == 0 || helpers.empty()) continue;
+    if (helpers.size() != static_cast<size_t>(dc_->k())) {
+      std::cerr << "Task " << cur_tid_ + j << " has " << helpers.size()
+                << " helpers, the code needs " << dc_->k() << std::endl;
+      exit(-1);
+    }
+
+    auto coefs = dc_->Get(blocks, failed - 1);
+    for (Count i = 0; i < helpers.size(); ++i)
+      coefs_[j * total_ + helpers[i]] = coefs[i];
+  }
+}
+
+//A node keeps a piece in the pool by its offset, in the lane of its task.
+//  Groups are chunks and run one after another, and the nodes' rows hold
+//  two windows side by side, so only the tasks of one window could meet
+//  there. Overlapping tasks must repair the same range for different
+//  targets in different lanes: their helpers load the range once for all
+//  of them, and each keeps its pieces in its own lane
+void Controller::CheckRanges_(const Count &gid) {
+  struct Range {
+    DataSize offset;
+    DataSize end;
+    Count target;
+    Count lane;
+  };
+  std::vector<Range> ranges;
+  auto srcs = std::make_unique<Count[]>(total_);
+  for (Count j = 0; j < task_num_; ++j) {
+    Count tid = cur_tid_ + j;
+    Range r{0, 0, 0, static_cast<Count>(tid % lanes_)};
+    for (Count nid = 1; nid < total_; ++nid) {
+      RepairTask rt{tid, 0, 0, win_offset_, win_size_, psize_, 1, 0, stripe_};
+      ptg_->FillTask(gid, j, nid, rt, srcs.get());
+      if (rt.size == 0) continue;
+      r.offset = rt.offset;
+      r.end = rt.offset + rt.size;
+      if (rt.tar_id == nid) r.target = nid;
+    }
+    if (r.end > r.offset) ranges.push_back(r);
+  }
+  std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) {
+    return a.offset < b.offset;
+  });
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    auto &a = ranges[i];
+    for (auto j = i + 1; j < ranges.size() && ranges[j].offset < a.end; ++j) {
+      auto &b = ranges[j];
+      if (a.offset == b.offset && a.end == b.end && a.target != b.target &&
+          a.lane != b.lane)
+        continue;
+      std::cerr << "Tasks of group " << gid << " overlap at " << b.offset
+                << ", they would share pool slots. Only tasks of the same "
+                << "range and different targets may, with a lane each of "
+                << "the " << lanes_ << " in the nodes' pools" << std::endl;
+      exit(-1);
+    }
+  }
+}
+
+//All the tasks of a node in the group go out as one plan message
 void Controller::DeliverTasks_(const Count &gid, const Count &nid){
   auto &srcs = src_lists_[nid - 1];
+  WireWriter plan(ac_.wire_version(nid));
+  RepairTask head{0, 0, 0, 0, 0, kPlanMessage, 0, 0};
   for (Count j = 0, tid = cur_tid_; j < task_num_; ++j, ++tid) {
     //Get task's content
-    RepairTask rt{tid, 0, 0, 0, size_, psize_, 1, 0};
+    RepairTask rt{tid, 0, 0, win_offset_, win_size_, psize_, 1, 0, stripe_};
     ptg_->FillTask(gid, j, nid, rt, srcs.get());
+    rt.coef = coefs_[j * total_ + nid];
+    //A version 1 node would take any chunk for chunk 0
+    if (rt.size > 0 && rt.chunk != 0 && ac_.wire_version(nid) < 2) {
+      std::cerr << "Node " << nid << " speaks wire version 1 and can't "
+                << "repair chunk " << rt.chunk << std::endl;
+      exit(-1);
+    }
 
-    //Send to the node
+    //Add to the node's plan
     if (rt.size > 0) {
-      ac_.Send(nid, sizeof(rt), &rt);
-      for (Count k = 0; k < rt.src_num; ++k)
-        ac_.Send(nid, sizeof(srcs[k]), &(srcs[k]));
+      plan.PutTask(rt);
+      for (Count i = 0; i < rt.src_num; ++i) plan.PutVarint(srcs[i]);
+      ++head.task_id;
       if (rt.tar_id == nid) {
         std::unique_lock<std::mutex> lck(mtx_);
-        waits_.push_back(nid);
+        waits_[tid] = nid;
         lck.unlock();
       }
     }
   }
+
+  //Send to the node
+  if (head.task_id == 0) return;
+  head.offset = plan.size();
+  ac_.SendTask(nid, head, plan.size(), plan.data());
 }
 
-void Controller::WaitForFinish_() {
-  //Wait for finish
-  Count recv;
-  for (auto &x: waits_)
-    ac_.Receive(x, sizeof(recv), &recv);
-  cur_tid_ += task_num_;
-  waits_.clear();
+//Acks of a later window may come first from the same node, they are
+//  crossed off as well
+void Controller::WaitForFinish_(const Count &first_tid) {
+  for (Count j = 0; j < task_num_; ++j) {
+    auto tid = static_cast<Count>(first_tid + j);
+    for (auto it = waits_.find(tid); it != waits_.end();
+         it = waits_.find(tid))
+      waits_.erase(ac_.ReceiveCount(it->second));
+  }
 }
 
 } // namespace exr
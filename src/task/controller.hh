@@ -3,10 +3,12 @@
 
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "data/access/access_center.hh"
 #include "task/task_getter_interface.hh"
+#include "util/decode_cache.hh"
 #include "util/typedef.hh"
 
 namespace exr {
@@ -15,11 +17,16 @@ namespace exr {
 class Controller
 {
  public:
-  Controller(const Count &total,
-             const DataSize &size, const DataSize &psize);
+  //window: bytes of the block repaired at a time, 0 for the whole block.
+  //  lanes: lanes of the nodes' memory pools, see MemoryPool
+  Controller(const Count &total, const DataSize &size,
+             const DataSize &psize, const DataSize &window = 0,
+             const Count &lanes = 1);
   ~Controller();
 
   void Connect(const IPAddressList &ip_addresses);
+  //Milliseconds spent connecting to the nodes
+  Time connect_time();
   void ChangeAlg(const Alg &alg, const Count *args, const Path &path);
 
   bool GetTasks();
@@ -35,21 +42,38 @@ class Controller
   Controller& operator=(const Controller&) = delete;
 
  private:
+  Count total_;
   DataSize size_;
   DataSize psize_;
+  DataSize window_;
+  Count lanes_;
   AccessCenter ac_;
   using pTaskGetter = std::unique_ptr<TaskGetterInterface>;
   pTaskGetter ptg_;
+  bool fixed_; //Tasks bring their own offsets, no window applies
 
   Count cur_tid_;
   Count gnum_;
+  //Every group repairs a stripe, whose blocks the nodes keep as this chunk
+  ChunkId stripe_;
   Count task_num_;
   std::unique_ptr<std::unique_ptr<Count[]>[]> src_lists_;
-  std::vector<Count> waits_;
+  //Decoding coefficient of every node in every task of the group, node i
+  //  keeping block i - 1 of the stripe. The cache is of the current
+  //  algorithm's code, none if it gave no code
+  std::unique_ptr<DecodeCache> dc_;
+  std::vector<RSUnit> coefs_;
+  //The window being delivered
+  DataSize win_offset_;
+  DataSize win_size_;
+  //Target node of every task not acknowledged yet
+  std::unordered_map<Count, Count> waits_;
   std::mutex mtx_;
 
+  void ComputeCoefs_(const Count &gid);
+  void CheckRanges_(const Count &gid);
   void DeliverTasks_(const Count &gid, const Count &nid);
-  void WaitForFinish_();
+  void WaitForFinish_(const Count &first_tid);
 };
 
 } // namespace exr
@@ -2,11 +2,13 @@
 #include <iostream>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "data/access/access_center.hh"
 #include "task/controller.hh"
 #include "util/typedef.hh"
 #include "util/types.hh"
+#include "util/wire.hh"
 
 int main()
 {
@@ -38,31 +40,39 @@ int main()
   std::mutex mtx;
   for (int i = 0; i < total - 1; ++i) {
     t[i] = std::thread([&, i] {
-      exr::RepairTask rt;
-      exr::Count c;
+      exr::RepairTask head, rt;
       while (true) {
-        ac[i].Receive(0, sizeof(rt), &rt);
-        if (rt.size == 0) break;
-        std::unique_lock<std::mutex> lck(mtx);
-        std::cout << std::endl
-                  << "node " << i + 1 << " receives: " << std::endl
-                  << "  task_id:   " << rt.task_id << std::endl
-                  << "  tar_id:    " << rt.tar_id << std::endl
-                  << "  offset:    " << rt.offset << std::endl
-                  << "  size:      " << rt.size << std::endl
-                  << "  psize:     " << rt.piece_size << std::endl
-                  << "  bandwidth: " << rt.bandwidth << std::endl
-                  << "  coef:      " << static_cast<int>(rt.coef)
-                  << std::endl << "  src_ids:   ";
-        for (exr::Count j = 0; j < rt.src_num; ++j) {
-          ac[i].Receive(0, sizeof(c), &c);
-          std::cout << c << " ";
-        }
-        std::cout << std::endl;
-        lck.unlock();
-        if (rt.tar_id == i + 1) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-          ac[i].Send(0, sizeof(c), &c);
+        ac[i].ReceiveTask(0, head);
+        if (head.piece_size != exr::kPlanMessage) break;
+        std::vector<exr::BufUnit> plan(head.offset);
+        ac[i].Receive(0, head.offset, plan.data());
+
+        exr::WireReader reader(plan.data(), plan.size(),
+                               ac[i].wire_version(0));
+        for (exr::Count k = 0; k < head.task_id; ++k) {
+          reader.GetTask(rt);
+          std::unique_lock<std::mutex> lck(mtx);
+          std::cout << std::endl
+                    << "node " << i + 1 << " receives: " << std::endl
+                    << "  task_id:   " << rt.task_id << std::endl
+                    << "  tar_id:    " << rt.tar_id << std::endl
+                    << "  offset:    " << rt.offset << std::endl
+                    << "  size:      " << rt.size << std::endl
+                    << "  psize:     " << rt.piece_size << std::endl
+                    << "  bandwidth: " << rt.bandwidth << std::endl
+                    << "  coef:      " << static_cast<int>(rt.coef)
+                    << std::endl << "  src_ids:   ";
+          for (exr::Count j = 0; j < rt.src_num; ++j) {
+            uint64_t c;
+            reader.GetVarint(c);
+            std::cout << c << " ";
+          }
+          std::cout << std::endl;
+          lck.unlock();
+          if (rt.tar_id == i + 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            ac[i].SendCount(0, rt.task_id);
+          }
         }
       }
     });
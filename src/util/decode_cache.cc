@@ -0,0 +1,66 @@
+#include "util/decode_cache.hh"
+
+#include <iostream>
+
+#include "util/rs_computer.hh"
+
+namespace exr {
+
+//Constructor and destructor
+DecodeCache::DecodeCache(const Count &n, const Count &k,
+                         const Count &capacity)
+    : n_(n), k_(k), capacity_(capacity), hits_(0), misses_(0) {}
+
+DecodeCache::~DecodeCache() = default;
+
+std::vector<RSUnit> DecodeCache::Get(const std::vector<Count> &survivors,
+                                     const Count &failed) {
+  Key key(survivors);
+  key.push_back(failed);
+
+  std::unique_lock<std::mutex> lck(mtx_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+  }
+  ++misses_;
+
+  //Invert the survivors' rows of the generator, which depends on k: only
+  //  k of them make a square matrix of the code the stripe was coded in
+  if (survivors.size() != static_cast<size_t>(k_)) {
+    std::cerr << "Cannot rebuild block " << failed << " from "
+              << survivors.size() << " blocks, the code needs " << k_
+              << std::endl;
+    exit(-1);
+  }
+  for (auto &s : survivors) {
+    if (s >= n_ || s == failed || failed >= n_) {
+      std::cerr << "Cannot rebuild block " << failed << " from block " << s
+                << std::endl;
+      exit(-1);
+    }
+  }
+  std::vector<RSUnit> coefs(k_);
+  RSComputer rc(n_, k_);
+  rc.InitForDecode();
+  rc.Decode(1, &failed, survivors.data(), coefs.data());
+
+  //Keep it, drop the least recently used pattern if full
+  lru_.emplace_front(std::move(key), coefs);
+  index_[lru_.front().first] = lru_.begin();
+  if (lru_.size() > capacity_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  return coefs;
+}
+
+Count DecodeCache::k() { return k_; }
+
+DataSize DecodeCache::hits() { return hits_; }
+
+DataSize DecodeCache::misses() { return misses_; }
+
+} // namespace exr
@@ -0,0 +1,59 @@
+#ifndef EXR_UTIL_DECODECACHE_HH_
+#define EXR_UTIL_DECODECACHE_HH_
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "util/typedef.hh"
+
+namespace exr {
+
+//Repair patterns whose coefficients are remembered
+const Count kDecodeCacheSize = 64;
+
+/* Decoding coefficients of a stripe coded by the systematic Cauchy matrix
+   of RSComputer. The coefficients of a (survivors, failed) pattern are
+   worked out once, by inverting the survivors' rows, and then kept in an
+   LRU cache, so a repeated pattern costs a lookup */
+class DecodeCache
+{
+ public:
+  //(n, k) of the code: n blocks in a stripe, any k of them rebuild another
+  DecodeCache(const Count &n, const Count &k,
+              const Count &capacity = kDecodeCacheSize);
+  ~DecodeCache();
+
+  //Coefficient of each survivor's block (indexes in the stripe, exactly k
+  //  of them) to rebuild the failed block
+  std::vector<RSUnit> Get(const std::vector<Count> &survivors,
+                          const Count &failed);
+
+  Count k();
+  //Lookups served from the cache and those which had to invert
+  DataSize hits();
+  DataSize misses();
+
+  //DecodeCache is neither copyable nor movable
+  DecodeCache(const DecodeCache&) = delete;
+  DecodeCache& operator=(const DecodeCache&) = delete;
+
+ private:
+  using Key = std::vector<Count>; //Survivors, then the failed block
+  using Entry = std::pair<Key, std::vector<RSUnit>>;
+
+  Count n_;
+  Count k_;
+  Count capacity_;
+  std::list<Entry> lru_; //Most recently used first
+  std::map<Key, std::list<Entry>::iterator> index_;
+  DataSize hits_;
+  DataSize misses_;
+  std::mutex mtx_;
+};
+
+} // namespace exr
+
+#endif // EXR_UTIL_DECODECACHE_HH_
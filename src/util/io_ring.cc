@@ -0,0 +1,176 @@
+#include "util/io_ring.hh"
+
+#include <cerrno>
+#include <iostream>
+
+#ifdef EXR_HAVE_LIBURING
+#include <liburing.h>
+#else
+struct io_uring {};
+#endif
+
+namespace exr {
+
+#ifdef EXR_HAVE_LIBURING
+
+//Skip the transferred bytes, return true if something remains
+static bool SkipDone(IORing::Op &op, DataSize done) {
+  Count k = 0;
+  while (k < op.num && done >= static_cast<DataSize>(op.iov[k].iov_len)) {
+    done -= op.iov[k].iov_len;
+    ++k;
+  }
+  for (Count i = k; i < op.num; ++i) op.iov[i - k] = op.iov[i];
+  op.num -= k;
+  if (op.num > 0) {
+    op.iov[0].iov_base = static_cast<BufUnit*>(op.iov[0].iov_base) + done;
+    op.iov[0].iov_len -= done;
+  }
+  return op.num > 0;
+}
+
+//Constructor and destructor
+IORing::IORing(const Count &depth) : depth_(depth), ring_(new io_uring) {
+  if (io_uring_queue_init(depth, ring_.get(), 0) < 0) {
+    std::cerr << "Create io_uring error" << std::endl;
+    exit(-1);
+  }
+}
+
+IORing::~IORing() { io_uring_queue_exit(ring_.get()); }
+
+//Check once whether the kernel allows creating a ring
+bool IORing::Supported() {
+  static const bool kSupported = [] {
+    io_uring ring;
+    if (io_uring_queue_init(2, &ring, 0) < 0) return false;
+    io_uring_queue_exit(&ring);
+    return true;
+  }();
+  return kSupported;
+}
+
+//Registering can fail by the memlock limit, then plain ops are used
+void IORing::RegisterBuffers(const Count &num, const iovec *iov) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  if (io_uring_register_buffers(ring_.get(), iov, num) < 0) {
+    std::cerr << "Register buffers to io_uring failed, "
+              << "using unregistered buffers" << std::endl;
+    return;
+  }
+  regs_.assign(iov, iov + num);
+}
+
+//Cloning needs liburing 2.8 and Linux 6.12, the pages are pinned and
+//  charged to the memlock limit only once for all the rings
+bool IORing::ShareBuffers(IORing &owner) {
+#if defined(IO_URING_VERSION_MAJOR) && (IO_URING_VERSION_MAJOR > 2 || \
+    (IO_URING_VERSION_MAJOR == 2 && IO_URING_VERSION_MINOR >= 8))
+  std::unique_lock<std::mutex> lck(mtx_);
+  std::unique_lock<std::mutex> owner_lck(owner.mtx_);
+  if (owner.regs_.empty() ||
+      io_uring_clone_buffers(ring_.get(), owner.ring_.get()) < 0)
+    return false;
+  regs_ = owner.regs_;
+  return true;
+#else
+  return false;
+#endif
+}
+
+//Submit the ops in batches of the ring's depth, resubmit the short ones
+bool IORing::Submit(const Count &num, Op *ops) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  std::vector<Op*> pending;
+  for (Count i = 0; i < num; ++i) {
+    ops[i].done = 0;
+    if (ops[i].num > 0) pending.push_back(ops + i);
+  }
+
+  bool ok = true;
+  while (ok && !pending.empty()) {
+    //Fill the submission queue
+    Count batch = 0;
+    for (; batch < pending.size() && batch < depth_; ++batch) {
+      auto &op = *(pending[batch]);
+      auto *sqe = io_uring_get_sqe(ring_.get());
+      DataSize offset = op.offset < 0 ? 0 : op.offset;
+      auto idx = FindRegistered_(op);
+      if (idx >= 0 && op.is_write) {
+        io_uring_prep_write_fixed(sqe, op.fd, op.iov[0].iov_base,
+                                  op.iov[0].iov_len, offset, idx);
+      } else if (idx >= 0) {
+        io_uring_prep_read_fixed(sqe, op.fd, op.iov[0].iov_base,
+                                 op.iov[0].iov_len, offset, idx);
+      } else if (op.is_write) {
+        io_uring_prep_writev(sqe, op.fd, op.iov, op.num, offset);
+      } else {
+        io_uring_prep_readv(sqe, op.fd, op.iov, op.num, offset);
+      }
+      io_uring_sqe_set_data(sqe, &op);
+    }
+    if (io_uring_submit_and_wait(ring_.get(), batch) < 0) return false;
+
+    //Reap all the completions of this batch
+    std::vector<Op*> next(pending.begin() + batch, pending.end());
+    for (Count i = 0; i < batch; ++i) {
+      io_uring_cqe *cqe;
+      if (io_uring_wait_cqe(ring_.get(), &cqe) < 0) return false;
+      auto &op = *static_cast<Op*>(io_uring_cqe_get_data(cqe));
+      auto res = cqe->res;
+      io_uring_cqe_seen(ring_.get(), cqe);
+
+      if (res == -EINTR || res == -EAGAIN) {
+        next.push_back(&op);
+      } else if (res < 0) {
+        ok = false;
+      } else if (res == 0) {
+        //Nothing moved on a socket means the peer is gone, on a file it is
+        //  the end of the file
+        if (op.offset < 0) ok = false;
+      } else {
+        op.done += res;
+        if (op.offset >= 0) op.offset += res;
+        if (SkipDone(op, res)) next.push_back(&op);
+      }
+    }
+    pending.swap(next);
+  }
+  return ok;
+}
+
+//Fixed ops take one buffer lying inside a registered one
+int IORing::FindRegistered_(const Op &op) {
+  if (op.num != 1) return -1;
+  auto *buf = static_cast<BufUnit*>(op.iov[0].iov_base);
+  for (Count i = 0; i < regs_.size(); ++i) {
+    auto *base = static_cast<BufUnit*>(regs_[i].iov_base);
+    if (buf >= base && buf + op.iov[0].iov_len <= base + regs_[i].iov_len)
+      return i;
+  }
+  return -1;
+}
+
+#else
+
+//Built without liburing: callers must check Supported() first
+IORing::IORing(const Count &depth) : depth_(depth) {
+  std::cerr << "Built without liburing, io_uring unavailable" << std::endl;
+  exit(-1);
+}
+
+IORing::~IORing() = default;
+
+bool IORing::Supported() { return false; }
+
+void IORing::RegisterBuffers(const Count &num, const iovec *iov) {}
+
+bool IORing::ShareBuffers(IORing &owner) { return false; }
+
+bool IORing::Submit(const Count &num, Op *ops) { return false; }
+
+int IORing::FindRegistered_(const Op &op) { return -1; }
+
+#endif
+
+} // namespace exr
@@ -0,0 +1,63 @@
+#ifndef EXR_UTIL_IORING_HH_
+#define EXR_UTIL_IORING_HH_
+
+#include <memory>
+#include <mutex>
+#include <sys/uio.h>
+#include <vector>
+
+#include "util/typedef.hh"
+
+struct io_uring;
+
+namespace exr {
+
+//Max number of buffers in one ring operation
+const Count kMaxRingVecNum = 8;
+
+/* A thin io_uring wrapper: several reads/writes are submitted as one batch
+   and waited for together. Only usable when built with liburing */
+class IORing
+{
+ public:
+  struct Op {
+    bool is_write;
+    int fd;
+    DataSize offset; //Position in a file, <0 for sockets
+    Count num;
+    iovec iov[kMaxRingVecNum];
+    DataSize done;   //Bytes transferred, filled by Submit
+  };
+
+  IORing(const Count &depth);
+  ~IORing();
+
+  //Whether io_uring was built in and is accepted by the kernel
+  static bool Supported();
+
+  //Pin buffers (e.g. MemoryPool's) so single-buffer ops skip page mapping
+  void RegisterBuffers(const Count &num, const iovec *iov);
+  //Use the buffers registered on owner without pinning them again, false
+  //  if the kernel or liburing can't share them
+  bool ShareBuffers(IORing &owner);
+
+  //Submit all ops at once and wait until each is finished,
+  //  a read stops early only at the end of a file, a closed socket fails
+  bool Submit(const Count &num, Op *ops);
+
+  //IORing is neither copyable nor movable
+  IORing(const IORing&) = delete;
+  IORing& operator=(const IORing&) = delete;
+
+ private:
+  Count depth_;
+  std::unique_ptr<io_uring> ring_;
+  std::vector<iovec> regs_; //Registered buffers
+  std::mutex mtx_;
+
+  int FindRegistered_(const Op &op);
+};
+
+} // namespace exr
+
+#endif // EXR_UTIL_IORING_HH_
@@ -1,18 +1,151 @@
 #include "util/memory_pool.hh"
 
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "util/numa.hh"
+
 namespace exr {
 
 //Constructor and destructor
-MemoryPool::MemoryPool(const Count &num, const DataSize &size)
-    : bufs_(new std::unique_ptr<BufUnit[]>[num]) {
-  for (Count i = 0; i < num; ++i)
-    bufs_[i] = std::make_unique<BufUnit[]>(size);
+MemoryPool::MemoryPool(const Count &num, const DataSize &size,
+                       const Count &lane_rows)
+    : num_(num), size_(size), lane_rows_(lane_rows > 0 ? lane_rows : num),
+      lanes_(Lanes(num, lane_rows_)), page_(sysconf(_SC_PAGESIZE)),
+      huge_(size >= kHugePageSize), reserved_(false), nodes_(NumaNodes()),
+      pinned_(false) {
+  auto unit = huge_ ? kHugePageSize : page_;
+  stride_ = (size + unit - 1) / unit * unit;
+  auto total = num * stride_;
+
+  //Transparent huge pages want a range aligned to them
+  raw_size_ = huge_ ? total + kHugePageSize : total;
+  void *mem = mmap(nullptr, raw_size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mem == MAP_FAILED) {
+    std::cerr << "Reserve memory pool of " << num << " x " << size
+              << " error" << std::endl;
+    exit(-1);
+  }
+  raw_ = static_cast<BufUnit*>(mem);
+  auto addr = reinterpret_cast<uintptr_t>(raw_);
+  base_ = raw_ + ((addr + unit - 1) / unit * unit - addr);
+  if (huge_ && madvise(base_, total, MADV_HUGEPAGE) != 0) huge_ = false;
+  if (huge_) {
+    live_.reset(new DataSize[total / kHugePageSize]());
+    live_mtxs_.reset(new std::mutex[total / kHugePageSize]);
+  }
+  Bind_();
 }
 
-MemoryPool::~MemoryPool() = default;
+MemoryPool::~MemoryPool() { munmap(raw_, raw_size_); }
+
+Count MemoryPool::Lanes(const Count &num, const Count &lane_rows) {
+  return std::max<Count>(1, lane_rows > 0 ? num / lane_rows : 1);
+}
 
 BufUnit* MemoryPool::Get(const Count &id, const DataSize &offset) {
-  return bufs_[id].get() + offset;
+  return base_ + id * stride_ + offset % size_;
+}
+
+BufUnit* MemoryPool::Get(const Count &task_id, const Count &id,
+                         const DataSize &offset) {
+  return Get(task_id % lanes_ * lane_rows_ + id, offset);
 }
 
+//Only huge pages count their pieces. Buffers not from the pool are left
+//  alone
+void MemoryPool::Place(BufUnit *buf, const DataSize &size) {
+  if (!huge_ || pinned_ || buf < base_ || buf + size > base_ + num_ * stride_)
+    return;
+  DataSize from = buf - base_, to = from + size;
+  for (auto p = from / kHugePageSize; p * kHugePageSize < to; ++p) {
+    auto lo = std::max(from, p * kHugePageSize);
+    auto hi = std::min(to, (p + 1) * kHugePageSize);
+    std::lock_guard<std::mutex> lck(live_mtxs_[p]);
+    live_[p] += hi - lo;
+  }
+}
+
+//Pages shared with a neighbouring piece stay, the piece may still be alive.
+//  A huge page is counted down instead, the last piece on it released drops
+//  it. Buffers not from the pool are left alone
+void MemoryPool::Release(BufUnit *buf, const DataSize &size) {
+  if (pinned_ || buf < base_ || buf + size > base_ + num_ * stride_) return;
+  DataSize from = buf - base_, to = from + size;
+  if (!huge_) {
+    auto begin = (from + page_ - 1) / page_ * page_;
+    auto end = to / page_ * page_;
+    if (end > begin) madvise(base_ + begin, end - begin, MADV_DONTNEED);
+    return;
+  }
+
+  //Bytes never placed can't tell whether the page is free, it is kept
+  for (auto p = from / kHugePageSize; p * kHugePageSize < to; ++p) {
+    auto lo = std::max(from, p * kHugePageSize);
+    auto hi = std::min(to, (p + 1) * kHugePageSize);
+    std::lock_guard<std::mutex> lck(live_mtxs_[p]);
+    if (live_[p] < hi - lo) {
+      live_[p] = 0;
+      continue;
+    }
+    live_[p] -= hi - lo;
+    if (live_[p] == 0)
+      madvise(base_ + p * kHugePageSize, kHugePageSize, MADV_DONTNEED);
+  }
+}
+
+//Reserved huge pages are taken all at once, so running short fails here
+//  instead of at a page fault. Then the transparent ones stay
+void MemoryPool::Pin() {
+  pinned_ = true;
+  if (!huge_ || reserved_) return;
+  auto total = num_ * stride_;
+  auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+  flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+  void *mem = mmap(nullptr, total, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mem == MAP_FAILED) return;
+  munmap(raw_, raw_size_);
+  raw_ = base_ = static_cast<BufUnit*>(mem);
+  raw_size_ = total;
+  page_ = kHugePageSize;
+  reserved_ = true;
+  Bind_();
+}
+
+//Every node has an arena of consecutive rows
+void MemoryPool::Bind_() {
+  if (nodes_ > 1)
+    for (Count i = 0; i < num_; ++i) BindMemory(Get(i, 0), stride_, node(i));
+}
+
+Count MemoryPool::num() { return num_; }
+
+DataSize MemoryPool::size() { return size_; }
+
+Count MemoryPool::lanes() { return lanes_; }
+
+Count MemoryPool::spare() { return lanes_ * lane_rows_; }
+
+DataSize MemoryPool::resident() {
+  DataSize page = sysconf(_SC_PAGESIZE), total = num_ * stride_;
+  std::vector<unsigned char> pages(total / page);
+  if (mincore(base_, total, pages.data()) != 0) return -1;
+  DataSize n = 0;
+  for (auto p : pages) n += p & 1;
+  return n * page;
+}
+
+bool MemoryPool::huge_pages() { return huge_; }
+
+bool MemoryPool::reserved() { return reserved_; }
+
+Count MemoryPool::node(const Count &id) { return id * nodes_ / num_; }
+
 } // namespace exr
@@ -2,27 +2,97 @@
 #define EXR_UTIL_MEMORYPOOL_HH_
 
 #include <memory>
+#include <mutex>
 
 #include "util/typedef.hh"
-#include "util/waiting_queue.hh"
 
 namespace exr {
 
-/* Allocate several memory bufs in advandce. Get them when needed */
+//Rows of at least this size are put on huge pages
+const DataSize kHugePageSize = 2 << 20;
+
+/* Memory bufs addressed by row and offset. The rows are only reserved in
+   advance: a page gets memory (already zeroed) when a piece is first put
+   on it, and goes back to the system once the piece is released, so the
+   memory in use follows the pieces in flight instead of the block size.
+   Large rows go on transparent huge pages. Releasing is what matters
+   there, so a huge page is kept whole until every piece placed on it is
+   released and then dropped at once: releasing 4 KiB pages out of it
+   would split it. Reserved huge pages can't be given back in part, they
+   are only taken by Pin, when nothing is released anymore.
+   Tasks repairing the same range at once keep their pieces apart in
+   lanes: the rows are split into lanes of lane_rows rows, a task using
+   the lane of its id modulo their number. The rows past the last lane
+   are spare.
+   On a NUMA machine the rows are split into one arena of consecutive rows
+   a node. Rows start at page boundaries, so pieces at aligned offsets suit
+   the SIMD kernels */
 class MemoryPool
 {
  public:
-  MemoryPool(const Count &num, const DataSize &size);
+  //lane_rows: rows of a lane, 0 for a single lane of all rows
+  MemoryPool(const Count &num, const DataSize &size,
+             const Count &lane_rows = 0);
   ~MemoryPool();
 
+  //Lanes that num rows hold, at least one
+  static Count Lanes(const Count &num, const Count &lane_rows);
+
+  //Offsets wrap around the row, so a row may hold a moving window of a
+  //  block larger than itself
   BufUnit* Get(const Count &id, const DataSize &offset);
+  //Row id of the task's lane
+  BufUnit* Get(const Count &task_id, const Count &id,
+               const DataSize &offset);
+  //A piece is about to be written at buf, before anything is written.
+  //  On huge pages its bytes keep their pages until it is released
+  void Place(BufUnit *buf, const DataSize &size);
+  //The piece at buf is consumed, the pages wholly inside it are dropped.
+  //  On huge pages a page is dropped once no piece placed on it is left
+  void Release(BufUnit *buf, const DataSize &size);
+  //The rows are registered somewhere (e.g. io_uring) which keeps their pages,
+  //  from now on nothing is dropped. Large rows move to reserved huge pages
+  //  if there are enough, so it must come before any Get
+  void Pin();
+
+  //Number and size of the bufs, e.g. to register them for io_uring
+  Count num();
+  DataSize size();
+  //Number of lanes, and the first row past them
+  Count lanes();
+  Count spare();
+  //Bytes currently backed by memory
+  DataSize resident();
+  //Whether the rows are on huge pages, and whether those are reserved
+  bool huge_pages();
+  bool reserved();
+  //NUMA node whose memory holds a row
+  Count node(const Count &id);
 
   //MemoryPool is neither copyable nor movable
   MemoryPool(const MemoryPool&) = delete;
   MemoryPool& operator=(const MemoryPool&) = delete;
 
  private:
-  std::unique_ptr<std::unique_ptr<BufUnit[]>[]> bufs_; //Memory units
+  Count num_;
+  DataSize size_;
+  Count lane_rows_;
+  Count lanes_;
+  DataSize stride_; //Row size rounded up to pages
+  DataSize page_;   //Granularity of releasing
+  bool huge_;
+  bool reserved_;
+  Count nodes_;
+  BufUnit *raw_;    //The mapping, base_ is aligned inside it
+  DataSize raw_size_;
+  BufUnit *base_;
+  bool pinned_;
+  //Bytes of the pieces placed on each huge page and not released yet,
+  //  the lock keeps a page from being dropped while a piece is placed
+  std::unique_ptr<DataSize[]> live_;
+  std::unique_ptr<std::mutex[]> live_mtxs_;
+
+  void Bind_();
 };
 
 } // namespace exr
@@ -0,0 +1,64 @@
+#include "util/numa.hh"
+
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace exr {
+
+//Policy of mbind(2), as in <numaif.h>
+const int kMpolPreferred = 1;
+//Nodes a mask of mbind can hold
+const Count kMaxNumaNodes = sizeof(unsigned long) * 8;
+
+//A sysfs list such as "0-3,8-11"
+static std::vector<int> ParseList(const Path &path) {
+  std::vector<int> ids;
+  std::ifstream in(path);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    std::istringstream is(item);
+    int first, last;
+    if (!(is >> first)) continue;
+    last = first;
+    if (is.get() == '-') is >> last;
+    for (int i = first; i <= last; ++i) ids.push_back(i);
+  }
+  return ids;
+}
+
+Count NumaNodes() {
+  static Count nodes = [] {
+    auto ids = ParseList("/sys/devices/system/node/online");
+    Count n = ids.empty() ? 1 : ids.back() + 1;
+    return n > kMaxNumaNodes ? kMaxNumaNodes : n;
+  }();
+  return nodes;
+}
+
+std::vector<int> NumaCpus(const Count &node) {
+  return ParseList("/sys/devices/system/node/node" + std::to_string(node) +
+                   "/cpulist");
+}
+
+bool BindThread(const Count &node) {
+  auto cpus = NumaCpus(node);
+  if (cpus.empty()) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus)
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool BindMemory(void *addr, const DataSize &size, const Count &node) {
+  if (node >= kMaxNumaNodes) return false;
+  unsigned long mask = 1UL << node;
+  return syscall(SYS_mbind, addr, size, kMpolPreferred, &mask,
+                 kMaxNumaNodes + 1, 0) == 0;
+}
+
+} // namespace exr
@@ -0,0 +1,24 @@
+#ifndef EXR_UTIL_NUMA_HH_
+#define EXR_UTIL_NUMA_HH_
+
+#include <vector>
+
+#include "util/typedef.hh"
+
+namespace exr {
+
+/* NUMA placement read from sysfs and set by raw syscalls, so no libnuma is
+   needed. On a machine of one node (or without sysfs) nothing is bound */
+
+//Nodes online, at least 1
+Count NumaNodes();
+//CPUs of a node
+std::vector<int> NumaCpus(const Count &node);
+//Run the calling thread on the CPUs of a node only
+bool BindThread(const Count &node);
+//Place the pages of a range on a node, other nodes when it is full
+bool BindMemory(void *addr, const DataSize &size, const Count &node);
+
+} // namespace exr
+
+#endif // EXR_UTIL_NUMA_HH_
@@ -1,12 +1,24 @@
 #include "util/rs_computer.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 #include "isa-l.h"
 
 namespace exr {
 
+//Bytes of an expanded table of one coefficient, and how gf_vect_mul wants
+//  its lengths and buffers aligned
+const DataSize kTableSize = 32;
+const uintptr_t kAlign = 32;
+//Bytes of each buffer combined at a time, the block of every source and
+//  of the target stay in L2 together
+const DataSize kCacheBlock = 32 << 10;
+
 //Constructor and destructor
 RSComputer::RSComputer(const Count cn, const Count ck) : cn_(cn), ck_(ck) {}
 
@@ -58,4 +70,129 @@ void RSComputer::Encode(const DataSize &size, void *srcs, void *tars) {
                  reinterpret_cast<RSUnit**>(tars));
 }
 
+//xor_gen wants the destination last and aligned buffers, anything else
+//  goes word by word
+void RSComputer::Xor(const DataSize &size, const Count &num, BufUnit **srcs,
+                     BufUnit *tar) {
+  bool aligned = size % kAlign == 0 &&
+                 reinterpret_cast<uintptr_t>(tar) % kAlign == 0;
+  for (Count i = 0; i < num; ++i)
+    aligned = aligned && reinterpret_cast<uintptr_t>(srcs[i]) % kAlign == 0;
+  if (aligned && num > 1) {
+    std::vector<void*> array(srcs, srcs + num);
+    array.push_back(tar);
+    if (xor_gen(num + 1, size, array.data()) == 0) return;
+  }
+
+  DataSize words = size / sizeof(uint64_t);
+  for (DataSize w = 0; w < words; ++w) {
+    uint64_t x = 0, v;
+    for (Count i = 0; i < num; ++i) {
+      memcpy(&v, srcs[i] + w * sizeof(v), sizeof(v));
+      x ^= v;
+    }
+    memcpy(tar + w * sizeof(x), &x, sizeof(x));
+  }
+  for (DataSize b = words * sizeof(uint64_t); b < size; ++b) {
+    BufUnit x = 0;
+    for (Count i = 0; i < num; ++i) x ^= srcs[i][b];
+    tar[b] = x;
+  }
+}
+
+void RSComputer::Multiply(const DataSize &size, const RSUnit &coef,
+                          const BufUnit *src, BufUnit *tar) {
+  if (coef == 0) {
+    memset(tar, 0, size);
+  } else if (coef == 1) {
+    if (src != tar) memcpy(tar, src, size);
+  } else if (size % kAlign == 0) {
+    gf_vect_mul(size, Table_(coef), const_cast<BufUnit*>(src), tar);
+  } else {
+    //gf_vect_mul takes whole 32-byte blocks only, a 1x1 encode takes any
+    RSUnit *srcs[1] = {reinterpret_cast<RSUnit*>(const_cast<BufUnit*>(src))},
+           *tars[1] = {reinterpret_cast<RSUnit*>(tar)};
+    ec_encode_data(size, 1, 1, Table_(coef), srcs, tars);
+  }
+}
+
+void RSComputer::MultiplyAdd(const DataSize &size, const RSUnit &coef,
+                             const BufUnit *src, BufUnit *tar) {
+  if (coef == 0) return;
+  if (coef == 1) {
+    BufUnit *srcs[2] = {const_cast<BufUnit*>(src), tar};
+    Xor(size, 2, srcs, tar);
+    return;
+  }
+  if (size < static_cast<DataSize>(kAlign)) {
+    //The SIMD gf_vect_mad leaves anything shorter than a vector untouched
+    auto *s = reinterpret_cast<const RSUnit*>(src);
+    auto *t = reinterpret_cast<RSUnit*>(tar);
+    for (DataSize b = 0; b < size; ++b) t[b] ^= gf_mul(coef, s[b]);
+    return;
+  }
+  gf_vect_mad(size, 1, 0, Table_(coef),
+              reinterpret_cast<RSUnit*>(const_cast<BufUnit*>(src)),
+              reinterpret_cast<RSUnit*>(tar));
+}
+
+//Sources multiplied by one are XORed in one pass, then the others are
+//  multiplied and accumulated, all on the same block
+void RSComputer::Combine(const DataSize &size, const Count &num,
+                         BufUnit **srcs, const RSUnit *coefs, BufUnit *tar) {
+  std::vector<BufUnit*> plain, scaled;
+  std::vector<RSUnit> scaled_coefs;
+  for (Count i = 0; i < num; ++i) {
+    if (coefs[i] == 1) {
+      plain.push_back(srcs[i]);
+    } else if (coefs[i] > 1) {
+      scaled.push_back(srcs[i]);
+      scaled_coefs.push_back(coefs[i]);
+    }
+  }
+
+  std::vector<BufUnit*> cur(plain.size());
+  for (DataSize done = 0; done < size; done += kCacheBlock) {
+    auto len = std::min(kCacheBlock, size - done);
+    Count first = 0;
+    if (!plain.empty()) {
+      for (Count i = 0; i < plain.size(); ++i) cur[i] = plain[i] + done;
+      Xor(len, cur.size(), cur.data(), tar + done);
+    } else if (!scaled.empty()) {
+      Multiply(len, scaled_coefs[0], scaled[0] + done, tar + done);
+      first = 1;
+    } else {
+      memset(tar + done, 0, len);
+    }
+    for (Count i = first; i < scaled.size(); ++i)
+      MultiplyAdd(len, scaled_coefs[i], scaled[i] + done, tar + done);
+  }
+}
+
+void RSComputer::MultiplyMany(const DataSize &size, const Count &num,
+                              const RSUnit *coefs, const BufUnit *src,
+                              BufUnit **tars) {
+  if (num == 1) {
+    Multiply(size, coefs[0], src, tars[0]);
+    return;
+  }
+  //A 1 x num encode, its tables are those of the coefficients in a row
+  std::vector<RSUnit> tables(num * kTableSize);
+  for (Count i = 0; i < num; ++i)
+    memcpy(tables.data() + i * kTableSize, Table_(coefs[i]), kTableSize);
+  RSUnit *srcs[1] = {reinterpret_cast<RSUnit*>(const_cast<BufUnit*>(src))};
+  ec_encode_data(size, 1, num, tables.data(), srcs,
+                 reinterpret_cast<RSUnit**>(tars));
+}
+
+//All 256 tables take 8 KiB, they are filled at the first use
+RSUnit* RSComputer::Table_(const RSUnit &coef) {
+  static RSUnit tables[256][kTableSize];
+  static std::once_flag flag;
+  std::call_once(flag, [] {
+    for (int c = 0; c < 256; ++c) gf_vect_mul_init(c, tables[c]);
+  });
+  return tables[coef];
+}
+
 } // namespace exr
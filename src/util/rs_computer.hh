@@ -25,6 +25,27 @@ class RSComputer
   void InitForEncode(RSUnit *coefs); //lenth of coefs is cn * ck
   void Encode(const DataSize &size, void *srcs, void *tars);
 
+  //XOR num sources into tar in a single pass: every source is read once
+  //  and tar written once, no matter how many sources there are
+  static void Xor(const DataSize &size, const Count &num, BufUnit **srcs,
+                  BufUnit *tar);
+
+  //A single coefficient: tar = coef * src, and tar ^= coef * src.
+  //  One is a copy or a plain XOR, the others use cached GF tables
+  static void Multiply(const DataSize &size, const RSUnit &coef,
+                       const BufUnit *src, BufUnit *tar);
+  static void MultiplyAdd(const DataSize &size, const RSUnit &coef,
+                          const BufUnit *src, BufUnit *tar);
+  //tar = sum of coefs[i] * srcs[i]. Done in cache-sized blocks: a block
+  //  of every source is combined into tar's block while it is still hot
+  static void Combine(const DataSize &size, const Count &num, BufUnit **srcs,
+                      const RSUnit *coefs, BufUnit *tar);
+  //Several coefficients of one source: tars[i] = coefs[i] * src, all the
+  //  products made in a single pass over src
+  static void MultiplyMany(const DataSize &size, const Count &num,
+                           const RSUnit *coefs, const BufUnit *src,
+                           BufUnit **tars);
+
   //RSComputer is neither copyable nor movable
   RSComputer(const RSComputer&) = delete;
   RSComputer& operator=(const RSComputer&) = delete;
@@ -33,6 +54,9 @@ class RSComputer
   Count cn_;
   Count ck_;
   std::unique_ptr<RSUnit[]> matrix_;
+
+  //Expanded multiplication table of a coefficient, built once per process
+  static RSUnit* Table_(const RSUnit &coef);
 };
 
 } // namespace exr
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "util/rs_computer.hh"
+#include "util/typedef.hh"
+
+//Cycle counter where there is one, nanoseconds elsewhere
+static uint64_t Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int main()
+{
+  const exr::Count num = 4, rounds = 8;
+  //Three forwarded pieces and the local one scaled by its coefficient
+  exr::RSUnit coefs[num] = {1, 1, 1, 0x57};
+  //The odd one ends in a block shorter than a SIMD vector
+  exr::DataSize sizes[] = {64 << 10, (64 << 10) + 17, 1 << 20, 4 << 20,
+                           16 << 20};
+
+  for (auto size : sizes) {
+    //aligned_alloc takes whole multiples of the alignment
+    auto alloc = (size + 63) / 64 * 64;
+    std::vector<exr::BufUnit*> srcs(num);
+    for (auto &s : srcs) {
+      s = static_cast<exr::BufUnit*>(aligned_alloc(64, alloc));
+      for (exr::DataSize i = 0; i < size; ++i) s[i] = rand();
+    }
+    auto *staged = static_cast<exr::BufUnit*>(aligned_alloc(64, alloc));
+    auto *fused = static_cast<exr::BufUnit*>(aligned_alloc(64, alloc));
+
+    //Per stage: XOR every plain piece over the whole size, then the
+    //  multiply and accumulate of the local piece over it again
+    uint64_t staged_ticks = 0, fused_ticks = 0;
+    for (exr::Count r = 0; r < rounds; ++r) {
+      auto t = Ticks();
+      exr::RSComputer::Xor(size, num - 1, srcs.data(), staged);
+      exr::RSComputer::MultiplyAdd(size, coefs[num - 1], srcs[num - 1],
+                                   staged);
+      staged_ticks += Ticks() - t;
+
+      t = Ticks();
+      exr::RSComputer::Combine(size, num, srcs.data(), coefs, fused);
+      fused_ticks += Ticks() - t;
+    }
+
+    double bytes = static_cast<double>(size) * (num + 1) * rounds;
+    std::cout << size << " bytes: per stage "
+              << bytes / staged_ticks << " bytes/tick, blocked "
+              << bytes / fused_ticks << " bytes/tick, "
+              << (memcmp(staged, fused, size) == 0 ? "same" : "DIFFERENT")
+              << std::endl;
+
+    for (auto s : srcs) free(s);
+    free(staged);
+    free(fused);
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "util/decode_cache.hh"
+#include "util/rs_computer.hh"
+#include "util/typedef.hh"
+
+int main()
+{
+  const exr::Count n = 6, k = 4;
+  //Not a whole number of cache blocks, the last one is 20 bytes
+  const exr::DataSize size = (32 << 10) + 20;
+
+  //A stripe: k data blocks and n - k parities
+  std::vector<std::vector<exr::BufUnit>> blocks(n,
+      std::vector<exr::BufUnit>(size));
+  for (exr::Count i = 0; i < k; ++i)
+    for (auto &c : blocks[i]) c = rand();
+  exr::RSComputer rc(n, k);
+  rc.InitForDecode();
+  exr::Count data_ids[k] = {0, 1, 2, 3}, parity_ids[n - k] = {4, 5};
+  exr::RSUnit pcoefs[(n - k) * k];
+  rc.Decode(n - k, parity_ids, data_ids, pcoefs);
+  exr::RSComputer enc(k, n - k);
+  enc.InitForEncode(pcoefs);
+  exr::BufUnit *srcs[k], *tars[n - k];
+  for (exr::Count i = 0; i < k; ++i) srcs[i] = blocks[i].data();
+  for (exr::Count i = 0; i < n - k; ++i) tars[i] = blocks[k + i].data();
+  enc.Encode(size, srcs, tars);
+
+  //Rebuild every block from the others, twice
+  exr::DecodeCache dc(n, k);
+  for (int round = 0; round < 2; ++round) {
+    for (exr::Count f = 0; f < n; ++f) {
+      std::vector<exr::Count> survivors;
+      for (exr::Count i = 0; i < n && survivors.size() < k; ++i)
+        if (i != f) survivors.push_back(i);
+      auto coefs = dc.Get(survivors, f);
+
+      std::vector<exr::BufUnit> out(size, 0), combined(size);
+      exr::BufUnit *helpers[k];
+      for (exr::Count i = 0; i < k; ++i) {
+        helpers[i] = blocks[survivors[i]].data();
+        exr::RSComputer::MultiplyAdd(size, coefs[i], helpers[i], out.data());
+      }
+      exr::RSComputer::Combine(size, k, helpers, coefs.data(),
+                               combined.data());
+      std::cout << "block " << f << " rebuilt: "
+                << (memcmp(out.data(), blocks[f].data(), size) == 0 ?
+                    "right" : "WRONG") << ", combined: "
+                << (memcmp(combined.data(), blocks[f].data(), size) == 0 ?
+                    "right" : "WRONG") << std::endl;
+    }
+  }
+  std::cout << "hits: " << dc.hits() << ", misses: " << dc.misses()
+            << std::endl;
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -8,12 +9,66 @@
 int main()
 {
   const exr::Count buf_num = 17;
-  const exr::DataSize size = 1 << 26;
+  const exr::DataSize size = 1 << 26, psize = 1 << 20;
   //
   //Init
   std::cout << "Initiate -- allocate blocks" << std::endl;
   exr::MemoryPool mp(buf_num, size);
   std::cout << "Allocated " << buf_num << " blocks with size: " << size
+            << ", resident: " << mp.resident() << std::endl;
+  std::cout << "huge pages: " << (mp.huge_pages() ? "yes" : "no")
+            << ", row 0 on node " << mp.node(0) << ", row "
+            << buf_num - 1 << " on node " << mp.node(buf_num - 1)
             << std::endl;
+
+  //Pieces in flight take memory, consumed ones give it back. On huge pages
+  //  a 2 MiB page goes once both of its 1 MiB pieces are released
+  for (exr::Count i = 0; i < 8; ++i) {
+    mp.Place(mp.Get(1, i * psize), psize);
+    memset(mp.Get(1, i * psize), i + 1, psize);
+  }
+  std::cout << "8 pieces put, resident: " << mp.resident() << std::endl;
+  for (exr::Count i = 0; i < 5; ++i)
+    mp.Release(mp.Get(1, i * psize), psize);
+  std::cout << "5 pieces released, resident: " << mp.resident()
+            << std::endl;
+  mp.Release(mp.Get(1, 5 * psize), psize);
+  std::cout << "6 pieces released, resident: " << mp.resident()
+            << std::endl;
+  std::cout << "piece 7 still holds: "
+            << static_cast<int>(*mp.Get(1, 7 * psize)) << std::endl;
+
+  //A piece placed where a released one was keeps the page, releasing its
+  //  neighbour of the generation before doesn't drop it
+  for (exr::Count i = 8; i < 10; ++i) {
+    mp.Place(mp.Get(1, i * psize), psize);
+    memset(mp.Get(1, i * psize), i + 1, psize);
+  }
+  mp.Release(mp.Get(1, 8 * psize), psize);
+  mp.Place(mp.Get(1, 8 * psize), psize);
+  memset(mp.Get(1, 8 * psize), 11, psize);
+  mp.Release(mp.Get(1, 9 * psize), psize);
+  std::cout << "piece 8 of the next generation still holds: "
+            << static_cast<int>(*mp.Get(1, 8 * psize)) << std::endl;
+  mp.Release(mp.Get(1, 8 * psize), psize);
+  std::cout << "both released, resident: " << mp.resident() << std::endl;
+
+  //Small rows give back every 4 KiB page a piece covers
+  exr::MemoryPool small(2, 1 << 20);
+  small.Place(small.Get(1, 0), 1 << 20);
+  memset(small.Get(1, 0), 1, 1 << 20);
+  small.Release(small.Get(1, 0), 1 << 19);
+  std::cout << "small rows, half released, resident: " << small.resident()
+            << std::endl;
+
+  //Pinned pools keep everything, and take reserved huge pages if they can
+  exr::MemoryPool pinned(buf_num, size);
+  pinned.Pin();
+  pinned.Place(pinned.Get(1, 0), psize);
+  memset(pinned.Get(1, 0), 1, psize);
+  pinned.Release(pinned.Get(1, 0), psize);
+  std::cout << "pinned, reserved huge pages: "
+            << (pinned.reserved() ? "yes" : "no") << ", resident: "
+            << pinned.resident() << std::endl;
   return 0;
 }
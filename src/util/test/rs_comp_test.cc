@@ -58,5 +58,39 @@ int main()
             << "coefs:" << std::endl
             << "\t" << static_cast<int>(coefs2[0]) << " "
                     << static_cast<int>(coefs2[1]) << std::endl;
+
+  //Fused XOR of several pieces
+  int x[3], *xsrcs[3] = {a, b, e};
+  exr::RSComputer::Xor(3 * sizeof(int), 3,
+                       reinterpret_cast<exr::BufUnit**>(xsrcs),
+                       reinterpret_cast<exr::BufUnit*>(x));
+  std::cout << std::endl << "a ^ b ^ e:" << std::endl
+            << "\tx: " << x[0] << " " << x[1] << " " << x[2] << std::endl
+            << "\texpected: " << (a[0] ^ b[0] ^ e[0]) << " "
+            << (a[1] ^ b[1] ^ e[1]) << " " << (a[2] ^ b[2] ^ e[2])
+            << std::endl;
+
+  //Repair a again with the single coefficient kernels
+  int y[3];
+  auto *yb = reinterpret_cast<exr::BufUnit*>(y);
+  exr::RSComputer::Multiply(3 * sizeof(int), coefs2[0],
+                            reinterpret_cast<exr::BufUnit*>(b), yb);
+  exr::RSComputer::MultiplyAdd(3 * sizeof(int), coefs2[1],
+                               reinterpret_cast<exr::BufUnit*>(d), yb);
+  std::cout << std::endl << "repair a by multiply and accumulate:"
+            << std::endl
+            << "\ty:" << y[0] << " " << y[1] << " " << y[2] << std::endl
+            << "\texpected: " << a[0] << " " << a[1] << " " << a[2]
+            << std::endl;
+
+  //One source multiplied by several coefficients at once
+  int m1[3], m2[3];
+  exr::BufUnit *mtars[2] = {reinterpret_cast<exr::BufUnit*>(m1),
+                            reinterpret_cast<exr::BufUnit*>(m2)};
+  exr::RSComputer::MultiplyMany(3 * sizeof(int), 2, coefs2,
+                                reinterpret_cast<exr::BufUnit*>(b), mtars);
+  std::cout << std::endl << "b by both coefs:" << std::endl
+            << "\tm1: " << m1[0] << " " << m1[1] << " " << m1[2] << std::endl
+            << "\tm2: " << m2[0] << " " << m2[1] << " " << m2[2] << std::endl;
   return 0;
 }
@@ -0,0 +1,29 @@
+#include <chrono>
+#include <iostream>
+
+#include "util/token_bucket.hh"
+#include "util/typedef.hh"
+
+int main()
+{
+  const exr::DataSize piece = 4096;
+  const int times = 200;
+  const exr::BwType rates[3] = {100000, 1000000, 0}; //Kbps
+
+  for (auto rate : rates) {
+    exr::TokenBucket tb(rate);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < times; ++i)
+      tb.Consume(piece);
+    auto us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "rate: " << rate << " Kbps" << std::endl
+              << "  sent " << times << " pieces of " << piece
+              << " bytes in " << us << " us" << std::endl;
+    if (rate > 0)
+      std::cout << "  expected: " << times * piece * 8000.0 / rate << " us"
+                << std::endl;
+  }
+  return 0;
+}
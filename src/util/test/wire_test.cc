@@ -0,0 +1,71 @@
+#include <iostream>
+
+#include "util/typedef.hh"
+#include "util/types.hh"
+#include "util/wire.hh"
+
+int main()
+{
+  //Fixed-size messages
+  exr::RepairTask rt{7, 3, 2, 1 << 20, 1 << 26, exr::kPlanMessage, 5, 250000,
+                     70000};
+  exr::BufUnit tbuf[exr::kWireTaskSize];
+  exr::EncodeTask(rt, tbuf);
+  auto rt2 = exr::DecodeTask(tbuf);
+  std::cout << "task: " << exr::kWireTaskSize << " bytes on the wire, "
+            << sizeof(rt) << " in memory" << std::endl;
+  rt2.show();
+
+  exr::PieceHeader ph{9, 65536, -16};
+  exr::BufUnit hbuf[exr::kWireHeaderSize];
+  exr::EncodeHeader(ph, hbuf);
+  auto ph2 = exr::DecodeHeader(hbuf);
+  std::cout << "header: " << ph2.task_id << " " << ph2.offset << " "
+            << ph2.size << std::endl;
+
+  //A plan read while it is still arriving
+  exr::WireWriter plan;
+  plan.PutTask(rt);
+  exr::Count srcs[3] = {1, 127, 300};
+  for (auto src : srcs) plan.PutVarint(src);
+  std::cout << "plan: " << plan.size() << " bytes" << std::endl;
+  for (exr::DataSize got = 0; got <= plan.size(); ++got) {
+    exr::WireReader reader(plan.data(), got);
+    exr::RepairTask rt3;
+    uint64_t v;
+    exr::Count n = 0;
+    if (!reader.GetTask(rt3)) continue;
+    while (n < rt3.src_num && reader.GetVarint(v)) ++n;
+    std::cout << "  " << got << " bytes: task " << rt3.task_id << " with "
+              << n << " sources, read " << reader.pos() << std::endl;
+  }
+  exr::WireReader reader(plan.data(), plan.size());
+  reader.GetTask(rt);
+  std::cout << "sources:";
+  for (exr::Count i = 0; i < rt.src_num; ++i) {
+    uint64_t v;
+    reader.GetVarint(v);
+    std::cout << " " << v;
+  }
+  std::cout << std::endl;
+
+  //A plan from a version 1 node, read by this one in the agreed version:
+  //  the chunk is not on the wire and comes back as 0
+  exr::WireWriter old_plan(1);
+  old_plan.PutTask(rt);
+  for (auto src : srcs) old_plan.PutVarint(src);
+  std::cout << "v1 plan: " << old_plan.size() << " bytes, task "
+            << exr::WireTaskSize(1) << " bytes" << std::endl;
+  exr::WireReader old_reader(old_plan.data(), old_plan.size(), 1);
+  exr::RepairTask rt4;
+  old_reader.GetTask(rt4);
+  rt4.show();
+  std::cout << "sources:";
+  for (exr::Count i = 0; i < rt4.src_num; ++i) {
+    uint64_t v;
+    old_reader.GetVarint(v);
+    std::cout << " " << v;
+  }
+  std::cout << std::endl;
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "util/token_bucket.hh"
+
+#include <thread>
+
+namespace exr {
+
+//Bytes may be saved up for this long when the flow is idle
+const double kBurstUs = 1000;
+//The last part of a wait is spent spinning instead of sleeping
+const TTime kSpinUs = 100;
+
+//Kbps to bytes per microsecond
+static double BytesPerUs(const BwType &rate) { return rate / 8000.0; }
+
+//Constructor and destructor
+TokenBucket::TokenBucket(const BwType &rate)
+    : rate_(rate), tokens_(0), last_(Clock::now()) {}
+
+TokenBucket::~TokenBucket() = default;
+
+void TokenBucket::SetRate(const BwType &rate) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  Refill_(Clock::now());
+  rate_ = rate;
+  if (rate_ == 0) tokens_ = 0;
+}
+
+//Pay for the bytes and tell how long the debt lasts
+TTime TokenBucket::Take(const DataSize &bytes) {
+  std::unique_lock<std::mutex> lck(mtx_);
+  if (rate_ == 0) return 0;
+  Refill_(Clock::now());
+  tokens_ -= bytes;
+  return tokens_ < 0 ? static_cast<TTime>(-tokens_ / BytesPerUs(rate_)) : 0;
+}
+
+void TokenBucket::Consume(const DataSize &bytes) { Wait(Take(bytes)); }
+
+//Sleep for the most part, then spin until the deadline
+void TokenBucket::Wait(const TTime &us) {
+  if (us <= 0) return;
+  auto until = Clock::now() + std::chrono::microseconds(us);
+  if (us > kSpinUs)
+    std::this_thread::sleep_for(std::chrono::microseconds(us - kSpinUs));
+  while (Clock::now() < until) std::this_thread::yield();
+}
+
+//Add the tokens earned since the last call, at most a burst's worth
+void TokenBucket::Refill_(const Clock::time_point &now) {
+  auto us = std::chrono::duration<double, std::micro>(now - last_).count();
+  last_ = now;
+  if (rate_ == 0) return;
+  auto burst = kBurstUs * BytesPerUs(rate_);
+  tokens_ += us * BytesPerUs(rate_);
+  if (tokens_ > burst) tokens_ = burst;
+}
+
+} // namespace exr
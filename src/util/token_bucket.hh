@@ -0,0 +1,49 @@
+#ifndef EXR_UTIL_TOKENBUCKET_HH_
+#define EXR_UTIL_TOKENBUCKET_HH_
+
+#include <chrono>
+#include <mutex>
+
+#include "util/typedef.hh"
+
+namespace exr {
+
+/* Limits a flow of bytes to a rate given in Kbps, the same unit as the
+   bandwidth files. The bucket may go into debt: a piece bigger than the
+   burst is let through and the following ones wait for it */
+class TokenBucket
+{
+ public:
+  //rate == 0 means unlimited
+  TokenBucket(const BwType &rate = 0);
+  ~TokenBucket();
+
+  //Change the rate, takes effect from now on
+  void SetRate(const BwType &rate);
+
+  //Take bytes, return the microseconds the caller must wait before use
+  TTime Take(const DataSize &bytes);
+  //Take bytes and wait until they may be used
+  void Consume(const DataSize &bytes);
+
+  //Sleep with sub-millisecond accuracy
+  static void Wait(const TTime &us);
+
+  //TokenBucket is neither copyable nor movable
+  TokenBucket(const TokenBucket&) = delete;
+  TokenBucket& operator=(const TokenBucket&) = delete;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  std::mutex mtx_;
+  BwType rate_;
+  double tokens_; //Bytes that may be sent now, negative in debt
+  Clock::time_point last_;
+
+  void Refill_(const Clock::time_point &now);
+};
+
+} // namespace exr
+
+#endif // EXR_UTIL_TOKENBUCKET_HH_
@@ -20,6 +20,9 @@ using DataSize = ssize_t;
 using BufUnit = char;
 using RSUnit = unsigned char;
 
+//Storage
+using ChunkId = uint32_t;
+
 //Socket
 using IP = std::string;
 using Port = uint16_t;
@@ -2,20 +2,23 @@
 #define EXR_UTIL_TYPES_HH_
 
 #include <iostream>
+#include <vector>
 
 #include "util/typedef.hh"
 
 namespace exr {
 
 struct RepairTask {
-  Count task_id;
+  Count task_id;        // PLAN: number of tasks
   Count src_num;
   Count tar_id;
   DataSize offset;      // BANDWIDTH_MESSAGE: =0, set; >0, load
-  DataSize size;        // =0, SPECIAL(end | BANDWIDTH_MESSAGE)
-  DataSize piece_size;  // SPECIAL: =0, end; >0, BANDWIDTH_MESSAGE
+                        // PLAN: bytes of the plan that follows
+  DataSize size;        // =0, SPECIAL(end | BANDWIDTH_MESSAGE | PLAN)
+  DataSize piece_size;  // SPECIAL: =0, end; >0, BANDWIDTH_MESSAGE; <0, PLAN
   RSUnit coef;
   BwType bandwidth;     // BANDWIDTH_MESSAGE: =0, set_full
+  ChunkId chunk;        // Chunk of the node's store, offset is inside it
 
   void show() const {
     std::cout << std::endl
@@ -26,13 +29,21 @@ struct RepairTask {
               << "size:      " << size << std::endl
               << "psize:     " << piece_size << std::endl
               << "coef:      " << static_cast<int>(coef) << std::endl
-              << "bandwidth: " << bandwidth << std::endl;
+              << "bandwidth: " << bandwidth << std::endl
+              << "chunk:     " << chunk << std::endl;
   }
 };
 
+//A PLAN is a group's tasks of one node: every RepairTask is followed by
+//  the ids of its src_num other sources
+const DataSize kPlanMessage = -1;
+
 struct ReceiveTask {
   RepairTask rt;
   Count src_id;
+  //A local load may serve several tasks which read the same data, each
+  //  repairing its own block for its own target
+  std::vector<RepairTask> more;
 
   void show() const {
     rt.show();
@@ -40,6 +51,8 @@ struct ReceiveTask {
   }
 };
 
+//A LOCAL piece is raw data, ComputeProcessor multiplies it by coef when
+//  combining (0 or 1: nothing to multiply)
 struct DataPiece {  // *  MESSAGE  *         LOCAL         *  NETWORK  * //
   Count task_id;    // *  task_id  *        task_id        *  task_id  * //
   DataSize offset;  // *     0     *        off-set        *  off-set  * //
@@ -48,6 +61,8 @@ struct DataPiece {  // *  MESSAGE  *         LOCAL         *  NETWORK  * //
   Count tar_id;     // *     0     *       target_id       *     0     * //
   Count src_num;    // *     0     *        src_num        *     0     * //
   TTime delay_time; // *     0     *       delaytime       *     0     * //
+  Count src_id;     // *     0     *           0           *  src_id   * //
+  RSUnit coef;      // *     0     *   coef    |     0     *     0     * //
 
   void show() const {
     std::cout << std::endl
@@ -56,6 +71,7 @@ struct DataPiece {  // *  MESSAGE  *         LOCAL         *  NETWORK  * //
               << "size:      " << size << std::endl
               << "tar_id:    " << tar_id << std::endl
               << "time:      " << delay_time << std::endl
+              << "coef:      " << static_cast<int>(coef) << std::endl
               << "buf:       ";
     if (buf)
       std::cout << "length of " << size;
@@ -65,6 +81,14 @@ struct DataPiece {  // *  MESSAGE  *         LOCAL         *  NETWORK  * //
   }
 };
 
+//Header sent in front of every data piece on the network. A header with
+//  a negative size has no payload: it grants -size pieces of credit
+struct PieceHeader {
+  Count task_id;
+  DataSize offset;
+  DataSize size;
+} __attribute__((packed));
+
 } // namespace exr
 
 #endif // EXR_UTIL_TYPES_HH_
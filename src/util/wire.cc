@@ -0,0 +1,123 @@
+#include "util/wire.hh"
+
+namespace exr {
+
+//Little-endian integers of n bytes
+static void PutLE(uint64_t v, const int &n, BufUnit *out) {
+  for (int i = 0; i < n; ++i, v >>= 8)
+    out[i] = static_cast<BufUnit>(v & 0xff);
+}
+
+static uint64_t GetLE(const BufUnit *in, const int &n) {
+  uint64_t v = 0;
+  for (int i = n - 1; i >= 0; --i)
+    v = (v << 8) | static_cast<uint8_t>(in[i]);
+  return v;
+}
+
+void EncodeCount(const Count &c, BufUnit *out) { PutLE(c, 2, out); }
+
+Count DecodeCount(const BufUnit *in) { return GetLE(in, 2); }
+
+//Version 1 has no chunk
+DataSize WireTaskSize(const Count &version) {
+  return version < 2 ? kWireTaskSize - 4 : kWireTaskSize;
+}
+
+void EncodeTask(const RepairTask &rt, BufUnit *out, const Count &version) {
+  PutLE(rt.task_id, 2, out);
+  PutLE(rt.src_num, 2, out + 2);
+  PutLE(rt.tar_id, 2, out + 4);
+  PutLE(rt.offset, 8, out + 6);
+  PutLE(rt.size, 8, out + 14);
+  PutLE(rt.piece_size, 8, out + 22);
+  PutLE(rt.coef, 1, out + 30);
+  PutLE(rt.bandwidth, 4, out + 31);
+  if (version >= 2) PutLE(rt.chunk, 4, out + 35);
+}
+
+RepairTask DecodeTask(const BufUnit *in, const Count &version) {
+  RepairTask rt;
+  rt.task_id = GetLE(in, 2);
+  rt.src_num = GetLE(in + 2, 2);
+  rt.tar_id = GetLE(in + 4, 2);
+  rt.offset = GetLE(in + 6, 8);
+  rt.size = GetLE(in + 14, 8);
+  rt.piece_size = GetLE(in + 22, 8);
+  rt.coef = GetLE(in + 30, 1);
+  rt.bandwidth = GetLE(in + 31, 4);
+  rt.chunk = version >= 2 ? GetLE(in + 35, 4) : 0;
+  return rt;
+}
+
+void EncodeHeader(const PieceHeader &ph, BufUnit *out) {
+  PutLE(ph.task_id, 2, out);
+  PutLE(ph.offset, 8, out + 2);
+  PutLE(ph.size, 8, out + 10);
+}
+
+PieceHeader DecodeHeader(const BufUnit *in) {
+  PieceHeader ph;
+  ph.task_id = GetLE(in, 2);
+  ph.offset = GetLE(in + 2, 8);
+  ph.size = GetLE(in + 10, 8);
+  return ph;
+}
+
+//Writer
+WireWriter::WireWriter(const Count &version) : version_(version) {}
+
+WireWriter::~WireWriter() = default;
+
+void WireWriter::PutTask(const RepairTask &rt) {
+  auto size = WireTaskSize(version_);
+  buf_.resize(buf_.size() + size);
+  EncodeTask(rt, buf_.data() + buf_.size() - size, version_);
+}
+
+//LEB128: 7 bits a byte, the high bit tells that more bytes follow
+void WireWriter::PutVarint(uint64_t v) {
+  while (v >= 0x80) {
+    buf_.push_back(static_cast<BufUnit>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  buf_.push_back(static_cast<BufUnit>(v));
+}
+
+BufUnit* WireWriter::data() { return buf_.data(); }
+
+DataSize WireWriter::size() { return buf_.size(); }
+
+//Reader
+WireReader::WireReader(const BufUnit *buf, const DataSize &size,
+                       const Count &version)
+    : version_(version), buf_(buf), size_(size), pos_(0) {}
+
+WireReader::~WireReader() = default;
+
+bool WireReader::GetTask(RepairTask &rt) {
+  auto size = WireTaskSize(version_);
+  if (size_ - pos_ < size) return false;
+  rt = DecodeTask(buf_ + pos_, version_);
+  pos_ += size;
+  return true;
+}
+
+bool WireReader::GetVarint(uint64_t &v) {
+  uint64_t r = 0;
+  for (DataSize i = pos_, shift = 0; i < size_ && shift < 64;
+       ++i, shift += 7) {
+    auto b = static_cast<uint8_t>(buf_[i]);
+    r |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      v = r;
+      pos_ = i + 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+DataSize WireReader::pos() { return pos_; }
+
+} // namespace exr
@@ -0,0 +1,79 @@
+#ifndef EXR_UTIL_WIRE_HH_
+#define EXR_UTIL_WIRE_HH_
+
+#include <vector>
+
+#include "util/typedef.hh"
+#include "util/types.hh"
+
+namespace exr {
+
+//Version of the messages between nodes. Two peers talk in the lower of
+//  their versions, a peer older than kMinWireVersion is refused. Tasks
+//  carry their chunk since version 2, a version 1 peer only knows chunk 0
+const Count kWireVersion = 2;
+const Count kMinWireVersion = 1;
+
+//Encoded sizes: little-endian fixed-width fields without any padding.
+//  kWireTaskSize is the size in the current version, the largest
+const DataSize kWireCountSize = 2;
+const DataSize kWireTaskSize = 2 + 2 + 2 + 8 + 8 + 8 + 1 + 4 + 4;
+const DataSize kWireHeaderSize = 2 + 8 + 8;
+const DataSize kWireHelloSize = 3 * kWireCountSize; //version, id, link
+
+//Fixed-size messages, for buffers of known length. Tasks are coded in the
+//  version agreed with the peer, fields it doesn't know are left at 0
+void EncodeCount(const Count &c, BufUnit *out);
+Count DecodeCount(const BufUnit *in);
+DataSize WireTaskSize(const Count &version = kWireVersion);
+void EncodeTask(const RepairTask &rt, BufUnit *out,
+                const Count &version = kWireVersion);
+RepairTask DecodeTask(const BufUnit *in,
+                      const Count &version = kWireVersion);
+void EncodeHeader(const PieceHeader &ph, BufUnit *out);
+PieceHeader DecodeHeader(const BufUnit *in);
+
+/* Builds a message of variable length, like a plan whose source lists
+   are varint-packed */
+class WireWriter
+{
+ public:
+  WireWriter(const Count &version = kWireVersion);
+  ~WireWriter();
+
+  void PutTask(const RepairTask &rt);
+  void PutVarint(uint64_t v);
+
+  BufUnit* data();
+  DataSize size();
+
+ private:
+  Count version_;
+  std::vector<BufUnit> buf_;
+};
+
+/* Reads a message back. A Get fails without consuming anything when the
+   bytes are not all there yet, so a message can be read while arriving */
+class WireReader
+{
+ public:
+  WireReader(const BufUnit *buf, const DataSize &size,
+             const Count &version = kWireVersion);
+  ~WireReader();
+
+  bool GetTask(RepairTask &rt);
+  bool GetVarint(uint64_t &v);
+
+  //Bytes consumed
+  DataSize pos();
+
+ private:
+  Count version_;
+  const BufUnit *buf_;
+  DataSize size_;
+  DataSize pos_;
+};
+
+} // namespace exr
+
+#endif // EXR_UTIL_WIRE_HH_